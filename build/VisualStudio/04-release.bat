@@ -24,18 +24,28 @@ rmdir examples
 
 mkdir performance
 cd performance
+xcopy /Y ..\..\performance\BoundaryBenchmark\bin\Release\*.* .
+xcopy /Y ..\..\performance\FootprintBenchmark\bin\Release\*.* .
 xcopy /Y ..\..\performance\SslEchoClient\bin\Release\*.* .
 xcopy /Y ..\..\performance\SslEchoServer\bin\Release\*.* .
+xcopy /Y ..\..\performance\SslHandshakeStorm\bin\Release\*.* .
 xcopy /Y ..\..\performance\SslMulticastClient\bin\Release\*.* .
 xcopy /Y ..\..\performance\SslMulticastServer\bin\Release\*.* .
+xcopy /Y ..\..\performance\TcpConnectStorm\bin\Release\*.* .
 xcopy /Y ..\..\performance\TcpEchoClient\bin\Release\*.* .
 xcopy /Y ..\..\performance\TcpEchoServer\bin\Release\*.* .
 xcopy /Y ..\..\performance\TcpMulticastClient\bin\Release\*.* .
 xcopy /Y ..\..\performance\TcpMulticastServer\bin\Release\*.* .
+xcopy /Y ..\..\performance\TcpProxyServer\bin\Release\*.* .
+xcopy /Y ..\..\performance\TimerWheelBenchmark\bin\Release\*.* .
 xcopy /Y ..\..\performance\UdpEchoClient\bin\Release\*.* .
 xcopy /Y ..\..\performance\UdpEchoServer\bin\Release\*.* .
 xcopy /Y ..\..\performance\UdpMulticastClient\bin\Release\*.* .
 xcopy /Y ..\..\performance\UdpMulticastServer\bin\Release\*.* .
+xcopy /Y ..\..\performance\UnixEchoClient\bin\Release\*.* .
+xcopy /Y ..\..\performance\UnixEchoServer\bin\Release\*.* .
+xcopy /Y ..\..\performance\UnixMulticastClient\bin\Release\*.* .
+xcopy /Y ..\..\performance\UnixMulticastServer\bin\Release\*.* .
 xcopy /Y ..\..\tools\certificates\*.pem .
 7z a ..\Benchmarks.zip *.*
 del /Q *.*
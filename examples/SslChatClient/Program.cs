@@ -11,7 +11,6 @@ namespace SslChatClient
 
         public void DisconnectAndStop()
         {
-            _stop = true;
             DisconnectAsync();
             while (IsConnected)
                 Thread.Yield();
@@ -30,13 +29,11 @@ namespace SslChatClient
         protected override void OnDisconnected()
         {
             Console.WriteLine($"Chat SSL client disconnected a session with Id {Id}");
+        }
 
-            // Wait for a while...
-            Thread.Sleep(1000);
-
-            // Try to connect again
-            if (!_stop)
-                ConnectAsync();
+        protected override void OnReconnectFailed()
+        {
+            Console.WriteLine($"Chat SSL client failed to reconnect a session with Id {Id}");
         }
 
         protected override void OnReceived(byte[] buffer, long size)
@@ -48,8 +45,6 @@ namespace SslChatClient
         {
             Console.WriteLine($"Chat SSL client caught an error with code {error} and category '{category}': {message}");
         }
-
-        private bool _stop;
     }
 
     class Program
@@ -89,6 +84,9 @@ namespace SslChatClient
             // Create a new SSL chat client
             var client = new ChatClient(service, context, address, port);
 
+            // Reconnect the lost client after a random delay from 0 to 1, 2, 4... 30 seconds
+            client.SetupReconnectDelay(TimeSpan.FromSeconds(1));
+
             // Connect the client
             Console.Write("Client connecting...");
             client.ConnectAsync();
@@ -103,11 +101,11 @@ namespace SslChatClient
                 if (line == string.Empty)
                     break;
 
-                // Disconnect the client
+                // Reconnect the client
                 if (line == "!")
                 {
-                    Console.Write("Client disconnecting...");
-                    client.DisconnectAsync();
+                    Console.Write("Client reconnecting...");
+                    client.ReconnectAsync();
                     Console.WriteLine("Done!");
                     continue;
                 }
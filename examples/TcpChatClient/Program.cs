@@ -11,7 +11,6 @@ namespace TcpChatClient
 
         public void DisconnectAndStop()
         {
-            _stop = true;
             DisconnectAsync();
             while (IsConnected)
                 Thread.Yield();
@@ -25,13 +24,11 @@ namespace TcpChatClient
         protected override void OnDisconnected()
         {
             Console.WriteLine($"Chat TCP client disconnected a session with Id {Id}");
+        }
 
-            // Wait for a while...
-            Thread.Sleep(1000);
-
-            // Try to connect again
-            if (!_stop)
-                ConnectAsync();
+        protected override void OnReconnectFailed()
+        {
+            Console.WriteLine($"Chat TCP client failed to reconnect a session with Id {Id}");
         }
 
         protected override void OnReceived(byte[] buffer, long size)
@@ -43,8 +40,6 @@ namespace TcpChatClient
         {
             Console.WriteLine($"Chat TCP client caught an error with code {error} and category '{category}': {message}");
         }
-
-        private bool _stop;
     }
 
     class Program
@@ -77,6 +72,9 @@ namespace TcpChatClient
             // Create a new TCP chat client
             var client = new ChatClient(service, address, port);
 
+            // Reconnect the lost client after a random delay from 0 to 1, 2, 4... 30 seconds
+            client.SetupReconnectDelay(TimeSpan.FromSeconds(1));
+
             // Connect the client
             Console.Write("Client connecting...");
             client.ConnectAsync();
@@ -91,11 +89,11 @@ namespace TcpChatClient
                 if (line == string.Empty)
                     break;
 
-                // Disconnect the client
+                // Reconnect the client
                 if (line == "!")
                 {
-                    Console.Write("Client disconnecting...");
-                    client.DisconnectAsync();
+                    Console.Write("Client reconnecting...");
+                    client.ReconnectAsync();
                     Console.WriteLine("Done!");
                     continue;
                 }
@@ -0,0 +1,388 @@
+﻿using System;
+using System.Diagnostics;
+using System.Net;
+using System.Net.Sockets;
+using System.Threading;
+using CSharpServer;
+using CSharpServer.Benchmarks;
+using NDesk.Options;
+
+namespace BoundaryBenchmark
+{
+    class BenchSession : TcpSession
+    {
+        public BenchSession(TcpServer server) : base(server) {}
+
+        protected override void OnConnected()
+        {
+            // The first session is connected to the sink client which never reads
+            if (Program.SinkSession == null)
+                Program.SinkSession = this;
+        }
+
+        protected override void OnReceived(byte[] buffer, long size)
+        {
+            // Pong the message back to the client
+            SendAsync(buffer, 0, size);
+        }
+    }
+
+    class BenchServer : TcpServer
+    {
+        public BenchServer(Service service, int port) : base(service, port) {}
+
+        protected override TcpSession CreateSession() { return new BenchSession(this); }
+    }
+
+    class BenchClient : TcpClient
+    {
+        public BenchClient(Service service, string address, int port) : base(service, address, port) {}
+
+        protected override void OnReceived(byte[] buffer, long size)
+        {
+            if (Program.PingPong && (Interlocked.Decrement(ref Program.Remaining) > 0))
+                SendAsync(buffer, 0, size);
+            else if (Program.PingPong)
+                Program.Done.Set();
+        }
+    }
+
+    class BenchUdpServer : UdpServer
+    {
+        public BenchUdpServer(Service service, int port) : base(service, port, InternetProtocol.IPv4) {}
+
+        protected override void OnStarted()
+        {
+            ReceiveAsync();
+        }
+
+        protected override void OnReceived(UdpEndpoint endpoint, byte[] buffer, long size)
+        {
+            // Pong the datagram back to the client
+            SendAsync(endpoint, buffer, 0, size);
+        }
+
+        protected override void OnSent(UdpEndpoint endpoint, long sent)
+        {
+            ReceiveAsync();
+        }
+    }
+
+    class BenchUdpClient : UdpClient
+    {
+        public BenchUdpClient(Service service, string address, int port) : base(service, address, port) {}
+
+        protected override void OnConnected()
+        {
+            ReceiveAsync();
+        }
+
+        protected override void OnReceived(UdpEndpoint endpoint, byte[] buffer, long size)
+        {
+            if (Program.PingPong && (Interlocked.Decrement(ref Program.Remaining) > 0))
+                SendAsync(buffer, 0, size);
+            else if (Program.PingPong)
+                Program.Done.Set();
+
+            ReceiveAsync();
+        }
+    }
+
+    class BenchTimer : Timer
+    {
+        public BenchTimer(Service service) : base(service) {}
+
+        protected override void OnTimer(bool canceled)
+        {
+            if (!Program.PingPong)
+                return;
+
+            // Re-arm the timer from its own callback
+            if (Interlocked.Decrement(ref Program.Remaining) > 0)
+            {
+                Setup(TimeSpan.Zero);
+                WaitAsync();
+            }
+            else
+                Program.Done.Set();
+        }
+    }
+
+    class Program
+    {
+        public static TcpSession SinkSession;
+        public static volatile bool PingPong;
+        public static long Remaining;
+        public static AutoResetEvent Done = new AutoResetEvent(false);
+        public static TimeSpan CallbackTimeout = TimeSpan.FromSeconds(30);
+
+        static BenchmarkResult Result;
+        static double Baseline;
+
+        // Measure the given call in isolation: nanoseconds and allocated bytes per call
+        // Allocations are counted for the whole AppDomain, so measured calls must not make a peer receive into managed code
+        static double Call(string name, long iterations, Action action)
+        {
+            // Warm-up the call path (JIT, native caches)
+            for (long i = 0; i < Math.Max(iterations / 10, 1); ++i)
+                action();
+
+            GC.Collect();
+            GC.WaitForPendingFinalizers();
+
+            long allocated = AppDomain.CurrentDomain.MonitoringTotalAllocatedMemorySize;
+            long start = Stopwatch.GetTimestamp();
+            for (long i = 0; i < iterations; ++i)
+                action();
+            long stop = Stopwatch.GetTimestamp();
+            allocated = AppDomain.CurrentDomain.MonitoringTotalAllocatedMemorySize - allocated;
+
+            double ns = (stop - start) * (1000000000.0 / Stopwatch.Frequency) / iterations;
+            Report(name, ns - Baseline, (double)allocated / iterations);
+            return ns;
+        }
+
+        // Measure the native to managed callback dispatch with a ping-pong of the given number of rounds
+        static void Callback(string name, long rounds, Action start)
+        {
+            for (int pass = 0; pass < 2; ++pass)
+            {
+                // The first pass warms up the path
+                long count = (pass == 0) ? Math.Max(rounds / 10, 1) : rounds;
+
+                GC.Collect();
+                GC.WaitForPendingFinalizers();
+
+                long allocated = AppDomain.CurrentDomain.MonitoringTotalAllocatedMemorySize;
+                long timestamp = Stopwatch.GetTimestamp();
+                Done.Reset();
+                Remaining = count;
+                PingPong = true;
+                start();
+                bool completed = Done.WaitOne(CallbackTimeout);
+                PingPong = false;
+                long elapsed = Stopwatch.GetTimestamp() - timestamp;
+                allocated = AppDomain.CurrentDomain.MonitoringTotalAllocatedMemorySize - allocated;
+
+                // Lost datagram breaks the ping-pong chain
+                if (!completed)
+                {
+                    Console.WriteLine($"{name,-48} timed out after {count - Interlocked.Read(ref Remaining)} of {count} rounds");
+                    Result?.Metric(name + ".timeout", 1);
+                    return;
+                }
+
+                if (pass > 0)
+                    Report(name, elapsed * (1000000000.0 / Stopwatch.Frequency) / count, (double)allocated / count);
+            }
+        }
+
+        static void Report(string name, double ns, double bytes)
+        {
+            Console.WriteLine($"{name,-48} {Math.Max(ns, 0.0),12:F1} ns/call {bytes,10:F1} B/call");
+            Result?.Metric(name + ".time", Math.Max(ns, 0.0)).Metric(name + ".allocated", bytes);
+        }
+
+        static void Main(string[] args)
+        {
+            bool help = false;
+            int port = 1111;
+            int threads = 1;
+            long iterations = 1000000;
+            long rounds = 100000;
+            int timeout = 30;
+            string json = null;
+
+            var options = new OptionSet()
+            {
+                { "h|?|help",   v => help = v != null },
+                { "p|port=", v => port = int.Parse(v) },
+                { "t|threads=", v => threads = int.Parse(v) },
+                { "i|iterations=", v => iterations = long.Parse(v) },
+                { "r|rounds=", v => rounds = long.Parse(v) },
+                { "o|timeout=", v => timeout = int.Parse(v) },
+                { "json=", v => json = v }
+            };
+
+            try
+            {
+                options.Parse(args);
+            }
+            catch (OptionException e)
+            {
+                Console.Write("Command line error: ");
+                Console.WriteLine(e.Message);
+                Console.WriteLine("Try `--help' to get usage information.");
+                return;
+            }
+
+            if (help)
+            {
+                Console.WriteLine("Usage:");
+                options.WriteOptionDescriptions(Console.Out);
+                Console.WriteLine();
+                Console.WriteLine("Measures each managed/native crossing in isolation. Calls report the");
+                Console.WriteLine("net time above an empty delegate call, callbacks report the whole");
+                Console.WriteLine("ping-pong round-trip including the native I/O path.");
+                Console.WriteLine("Sends are measured against peers which never read, so the allocated");
+                Console.WriteLine("bytes are those of the measured call only. Callback ping-pong gives up");
+                Console.WriteLine("after --timeout seconds (e.g. a lost UDP datagram).");
+                return;
+            }
+
+            // Capture process CPU time and GC collections from the very beginning
+            AppDomain.MonitoringIsEnabled = true;
+            Result = (json != null) ? new BenchmarkResult("Boundary") : null;
+            CallbackTimeout = TimeSpan.FromSeconds(timeout);
+
+            Console.WriteLine($"Server port: {port} (TCP and UDP)");
+            Console.WriteLine($"Working threads: {threads}");
+            Console.WriteLine($"Call iterations: {iterations}");
+            Console.WriteLine($"Callback rounds: {rounds}");
+            Console.WriteLine($"Callback timeout: {timeout} s");
+
+            Console.WriteLine();
+
+            // Create and start a new service
+            var service = new Service(threads);
+            service.Start();
+
+            // Create TCP server and connect the sink client synchronously, so it never receives data
+            var server = new BenchServer(service, port);
+            server.SetupReuseAddress(true);
+            server.Start();
+            var sink = new TcpClient(service, "127.0.0.1", port);
+            sink.Connect();
+            while (SinkSession == null)
+                Thread.Yield();
+
+            // Connect the ping-pong client
+            var client = new BenchClient(service, "127.0.0.1", port);
+            client.ConnectAsync();
+            while (!client.IsConnected || (server.ConnectedSessions < 2))
+                Thread.Yield();
+
+            // Create and connect UDP server and client
+            var udpServer = new BenchUdpServer(service, port);
+            udpServer.Start();
+            var udpClient = new BenchUdpClient(service, "127.0.0.1", port);
+            udpClient.ConnectAsync();
+            while (!udpClient.IsConnected)
+                Thread.Yield();
+
+            // Datagrams sent to the sink socket which is never read are dropped by the system
+            var udpSink = new Socket(AddressFamily.InterNetwork, SocketType.Dgram, ProtocolType.Udp);
+            udpSink.Bind(new IPEndPoint(IPAddress.Loopback, 0));
+            var endpoint = new UdpEndpoint("127.0.0.1", ((IPEndPoint)udpSink.LocalEndPoint).Port);
+
+            var timer = new BenchTimer(service);
+
+            var empty = new byte[0];
+            var small = new byte[1];
+
+            // Calibrate the delegate invocation cost which is subtracted from all calls
+            Baseline = Call("Baseline (empty delegate)", iterations, () => {});
+
+            Console.WriteLine();
+            Console.WriteLine("Service (managed -> native):");
+            Call("Service.IsStarted", iterations, () => { bool result = service.IsStarted; });
+            Call("Service.IsPolling", iterations, () => { bool result = service.IsPolling; });
+            Call("Service.Threads", iterations, () => { int result = service.Threads; });
+
+            Console.WriteLine();
+            Console.WriteLine("TcpServer (managed -> native):");
+            Call("TcpServer.Id", iterations, () => { string result = server.Id; });
+            Call("TcpServer.IsStarted", iterations, () => { bool result = server.IsStarted; });
+            Call("TcpServer.ConnectedSessions", iterations, () => { long result = server.ConnectedSessions; });
+            Call("TcpServer.BytesPending (2 sessions)", iterations, () => { long result = server.BytesPending; });
+            var serverStats = new ServerStats();
+            Call("TcpServer.GetStatistics", iterations, () => server.GetStatistics(ref serverStats));
+            string sessionId = SinkSession.Id;
+            Call("TcpServer.FindSession", iterations, () => { TcpSession result = server.FindSession(sessionId); });
+
+            Console.WriteLine();
+            Console.WriteLine("TcpSession (managed -> native):");
+            var session = SinkSession;
+            Call("TcpSession.Id", iterations, () => { string result = session.Id; });
+            Call("TcpSession.IsConnected", iterations, () => { bool result = session.IsConnected; });
+            Call("TcpSession.BytesPending", iterations, () => { long result = session.BytesPending; });
+            Call("TcpSession.BytesSent", iterations, () => { long result = session.BytesSent; });
+            Call("TcpSession.BytesReceived", iterations, () => { long result = session.BytesReceived; });
+            Call("TcpSession.OptionReceiveBufferSize", iterations, () => { long result = session.OptionReceiveBufferSize; });
+            Call("TcpSession.SetupReceiveBufferLimit", iterations, () => session.SetupReceiveBufferLimit(0));
+            Call("TcpSession.SendAsync(byte[0])", iterations, () => session.SendAsync(empty));
+            Call("TcpSession.SendAsync(byte[1])", rounds, () => session.SendAsync(small));
+            Call("TcpSession.SendAsync(string)", rounds, () => session.SendAsync("x"));
+
+            Console.WriteLine();
+            Console.WriteLine("TcpClient (managed -> native):");
+            Call("TcpClient.Id", iterations, () => { string result = client.Id; });
+            Call("TcpClient.Address", iterations, () => { string result = client.Address; });
+            Call("TcpClient.IsConnected", iterations, () => { bool result = client.IsConnected; });
+            Call("TcpClient.BytesPending", iterations, () => { long result = client.BytesPending; });
+            Call("TcpClient.OptionNoDelay", iterations, () => { bool result = client.OptionNoDelay; });
+
+            Console.WriteLine();
+            Console.WriteLine("TcpClientPool (managed -> native):");
+            var pool = new TcpClientPool(service);
+            pool.AddEndpoint("127.0.0.1", port, 16);
+            pool.Start();
+            while (pool.ReadyCount < pool.Count)
+                Thread.Yield();
+            Call("TcpClientPool.Select (16 clients)", iterations, () => { TcpClient result = pool.Select(); });
+            Call("TcpClientPool.SendAsync(byte[0])", iterations, () => pool.SendAsync(empty));
+
+            Console.WriteLine();
+            Console.WriteLine("UdpServer (managed -> native):");
+            Call("UdpServer.Id", iterations, () => { string result = udpServer.Id; });
+            Call("UdpServer.IsStarted", iterations, () => { bool result = udpServer.IsStarted; });
+            Call("UdpServer.BytesSent", iterations, () => { long result = udpServer.BytesSent; });
+            Call("UdpServer.DatagramsReceived", iterations, () => { long result = udpServer.DatagramsReceived; });
+            Call("UdpServer.OptionReceiveBufferSize", iterations, () => { long result = udpServer.OptionReceiveBufferSize; });
+            Call("UdpServer.Send(endpoint, byte[1])", rounds, () => udpServer.Send(endpoint, small));
+
+            Console.WriteLine();
+            Console.WriteLine("UdpClient (managed -> native):");
+            Call("UdpClient.Id", iterations, () => { string result = udpClient.Id; });
+            Call("UdpClient.IsConnected", iterations, () => { bool result = udpClient.IsConnected; });
+            Call("UdpClient.DatagramsSent", iterations, () => { long result = udpClient.DatagramsSent; });
+
+            Console.WriteLine();
+            Console.WriteLine("Timer (managed -> native):");
+            Call("Timer.Setup(TimeSpan)", iterations, () => timer.Setup(TimeSpan.FromHours(1)));
+            Call("Timer.Setup(DateTime)", iterations, () => timer.Setup(DateTime.UtcNow.AddHours(1)));
+            Call("Timer.ExpireTime", iterations, () => { DateTime result = timer.ExpireTime; });
+            Call("Timer.ExpireTimeSpan", iterations, () => { TimeSpan result = timer.ExpireTimeSpan; });
+            Call("Timer.WaitAsync + Cancel", rounds, () => { timer.WaitAsync(); timer.Cancel(); });
+
+            Console.WriteLine();
+            Console.WriteLine("Callbacks (native -> managed, per round-trip):");
+            Thread.Sleep(100);
+            Callback("TcpSession.OnReceived + TcpClient.OnReceived", rounds, () => client.SendAsync(small));
+            Callback("UdpServer.OnReceived + UdpClient.OnReceived", rounds, () => udpClient.SendAsync(small));
+            Callback("Timer.OnTimer", rounds, () => { timer.Setup(TimeSpan.Zero); timer.WaitAsync(); });
+
+            // Stop everything
+            pool.Stop();
+            client.Disconnect();
+            sink.Disconnect();
+            udpClient.Disconnect();
+            udpSink.Close();
+            server.Stop();
+            udpServer.Stop();
+            service.Stop();
+
+            if (json != null)
+            {
+                Result
+                    .Parameter("port", port)
+                    .Parameter("threads", threads)
+                    .Parameter("iterations", iterations)
+                    .Parameter("rounds", rounds)
+                    .Parameter("timeout", timeout)
+                    .Metric("baseline", Baseline)
+                    .Write(json);
+            }
+        }
+    }
+}
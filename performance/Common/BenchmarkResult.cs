@@ -0,0 +1,126 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Globalization;
+using System.IO;
+using System.Text;
+using CSharpServer;
+
+namespace CSharpServer.Benchmarks
+{
+    /// <summary>
+    /// Machine-readable benchmark result written as a single JSON object.
+    /// Process CPU time and GC collection counts are captured automatically.
+    /// Linked into each performance project as Common\BenchmarkResult.cs.
+    /// </summary>
+    public class BenchmarkResult
+    {
+        public BenchmarkResult(string benchmark)
+        {
+            _benchmark = benchmark;
+            _cpu = Process.GetCurrentProcess().TotalProcessorTime;
+            for (int i = 0; i < _collections.Length; ++i)
+                _collections[i] = GC.CollectionCount(i);
+        }
+
+        /// <summary>Add benchmark parameter</summary>
+        public BenchmarkResult Parameter(string name, object value)
+        {
+            _parameters.Add(new KeyValuePair<string, object>(name, value));
+            return this;
+        }
+
+        /// <summary>Add benchmark metric</summary>
+        public BenchmarkResult Metric(string name, double value)
+        {
+            _metrics.Add(new KeyValuePair<string, double>(name, value));
+            return this;
+        }
+
+        /// <summary>Add latency percentiles metrics in nanoseconds</summary>
+        public BenchmarkResult Latency(string name, LatencyHistogram histogram)
+        {
+            if (histogram.TotalCount == 0)
+                return this;
+
+            Metric(name + ".count", histogram.TotalCount);
+            Metric(name + ".min", histogram.Min);
+            Metric(name + ".mean", histogram.Mean);
+            Metric(name + ".p50", histogram.ValueAtPercentile(50));
+            Metric(name + ".p90", histogram.ValueAtPercentile(90));
+            Metric(name + ".p99", histogram.ValueAtPercentile(99));
+            Metric(name + ".p99.9", histogram.ValueAtPercentile(99.9));
+            Metric(name + ".max", histogram.Max);
+            return this;
+        }
+
+        /// <summary>Write the result into the given file ("-" for the console)</summary>
+        public void Write(string filename)
+        {
+            Metric("cpu.time", (Process.GetCurrentProcess().TotalProcessorTime - _cpu).TotalMilliseconds * 1000000.0);
+            for (int i = 0; i < _collections.Length; ++i)
+                Metric($"gc.gen{i}", GC.CollectionCount(i) - _collections[i]);
+
+            var json = new StringBuilder();
+            json.Append("{\n");
+            json.Append($"  \"benchmark\": {Quote(_benchmark)},\n");
+            json.Append($"  \"timestamp\": {Quote(DateTime.UtcNow.ToString("o"))},\n");
+            json.Append($"  \"machine\": {Quote(Environment.MachineName)},\n");
+            json.Append($"  \"processors\": {Environment.ProcessorCount},\n");
+            json.Append("  \"parameters\": {");
+            for (int i = 0; i < _parameters.Count; ++i)
+                json.Append($"{((i > 0) ? "," : "")}\n    {Quote(_parameters[i].Key)}: {Value(_parameters[i].Value)}");
+            json.Append("\n  },\n");
+            json.Append("  \"metrics\": {");
+            for (int i = 0; i < _metrics.Count; ++i)
+                json.Append($"{((i > 0) ? "," : "")}\n    {Quote(_metrics[i].Key)}: {_metrics[i].Value.ToString("R", CultureInfo.InvariantCulture)}");
+            json.Append("\n  }\n");
+            json.Append("}\n");
+
+            if (filename == "-")
+                Console.Write(json.ToString());
+            else
+                File.WriteAllText(filename, json.ToString());
+        }
+
+        private static string Quote(string value)
+        {
+            var result = new StringBuilder("\"");
+            foreach (char c in value)
+            {
+                switch (c)
+                {
+                    case '"': result.Append("\\\""); break;
+                    case '\\': result.Append("\\\\"); break;
+                    case '\n': result.Append("\\n"); break;
+                    case '\r': result.Append("\\r"); break;
+                    case '\t': result.Append("\\t"); break;
+                    default:
+                        if (c < ' ')
+                            result.Append($"\\u{(int)c:x4}");
+                        else
+                            result.Append(c);
+                        break;
+                }
+            }
+            return result.Append('"').ToString();
+        }
+
+        private static string Value(object value)
+        {
+            switch (value)
+            {
+                case bool b: return b ? "true" : "false";
+                case string s: return Quote(s);
+                case IFormattable f: return f.ToString(null, CultureInfo.InvariantCulture);
+                default: return Quote(value.ToString());
+            }
+        }
+
+        private readonly string _benchmark;
+        private readonly TimeSpan _cpu;
+        private readonly int[] _collections = new int[3];
+        private readonly List<KeyValuePair<string, object>> _parameters = new List<KeyValuePair<string, object>>();
+        private readonly List<KeyValuePair<string, double>> _metrics = new List<KeyValuePair<string, double>>();
+    }
+}
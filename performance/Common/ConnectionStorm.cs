@@ -0,0 +1,286 @@
+﻿using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Threading;
+using CSharpServer;
+using NDesk.Options;
+
+namespace CSharpServer.Benchmarks
+{
+    /// <summary>
+    /// Client of the connection storm.
+    /// </summary>
+    public interface IStormClient
+    {
+        /// <summary>Connect the client asynchronously from the given intended connect time</summary>
+        bool Connect(long timestamp);
+        /// <summary>Disconnect the client asynchronously</summary>
+        bool DisconnectAsync();
+    }
+
+    /// <summary>
+    /// Connection storm shared by TcpConnectStorm and SslHandshakeStorm.
+    /// Opens connections at the fixed rate from their intended connect time,
+    /// closes them immediately or after the hold time and samples the accept
+    /// rate of the in-process server. Clients return themselves to the idle
+    /// queue when disconnected.
+    /// Linked into storm projects as Common\ConnectionStorm.cs.
+    /// </summary>
+    public class ConnectionStorm
+    {
+        public ConnectionStorm(int port)
+        {
+            Port = port;
+        }
+
+        /// <summary>Server address</summary>
+        public string Address { get; set; } = "127.0.0.1";
+        /// <summary>Server port</summary>
+        public int Port { get; set; }
+        /// <summary>Working threads</summary>
+        public int Threads { get; set; } = Environment.ProcessorCount;
+        /// <summary>Maximal number of concurrent clients</summary>
+        public int Clients { get; set; } = 1000;
+        /// <summary>Connect rate in connections per second</summary>
+        public long Rate { get; set; } = 1000;
+        /// <summary>Connection hold time in milliseconds</summary>
+        public int Hold { get; set; }
+        /// <summary>Seconds to benchmarking</summary>
+        public int Seconds { get; set; } = 10;
+        /// <summary>Seconds to warm-up</summary>
+        public int Warmup { get; set; } = 1;
+        /// <summary>Is the server hosted by another process?</summary>
+        public bool External { get; set; }
+        /// <summary>JSON result filename (null to skip)</summary>
+        public string Json { get; set; }
+
+        /// <summary>Idle clients ready to connect</summary>
+        public ConcurrentQueue<IStormClient> Idle { get; } = new ConcurrentQueue<IStormClient>();
+        /// <summary>Connect latency from the intended connect time</summary>
+        public LatencyHistogram ConnectLatency { get; } = new LatencyHistogram();
+        /// <summary>Start timestamp of the storm run</summary>
+        public long Start { get; private set; }
+        /// <summary>Connects skipped because no client was idle</summary>
+        public long Skipped { get; private set; }
+        /// <summary>Peak of the sampled server accept rate</summary>
+        public double AcceptRatePeak { get; private set; }
+        /// <summary>Process CPU time of the storm run</summary>
+        public TimeSpan CpuTime { get; private set; }
+        /// <summary>Connects completed during the storm run</summary>
+        public long Connects { get; private set; }
+        /// <summary>Managed memory per connection, client and server side together</summary>
+        public double MemoryManaged { get; private set; }
+        /// <summary>Private memory per connection, client and server side together</summary>
+        public double MemoryPrivate { get; private set; }
+
+        public long TotalConnects;
+        public long TotalErrors;
+
+        /// <summary>Add storm options to the command line option set</summary>
+        public void AddOptions(OptionSet options)
+        {
+            options.Add("a|address=", "server address", v => Address = v);
+            options.Add("p|port=", "server port", v => Port = int.Parse(v));
+            options.Add("t|threads=", "working threads", v => Threads = int.Parse(v));
+            options.Add("c|clients=", "maximal number of concurrent clients", v => Clients = int.Parse(v));
+            options.Add("r|rate=", "connections per second", v => Rate = long.Parse(v));
+            options.Add("o|hold=", "connection hold time in milliseconds", v => Hold = int.Parse(v));
+            options.Add("z|seconds=", "seconds to benchmarking", v => Seconds = int.Parse(v));
+            options.Add("w|warmup=", "seconds to warm-up", v => Warmup = int.Parse(v));
+            options.Add("e|external", "connect to the external server", v => External = v != null);
+            options.Add("json=", "JSON result filename", v => Json = v);
+        }
+
+        /// <summary>Print the storm settings</summary>
+        public void Print()
+        {
+            Console.WriteLine($"Server address: {Address}");
+            Console.WriteLine($"Server port: {Port}");
+            Console.WriteLine($"Server hosting: {(External ? "external" : "in-process")}");
+            Console.WriteLine($"Working threads: {Threads}");
+            Console.WriteLine($"Working clients: {Clients}");
+            Console.WriteLine($"Connect rate: {Rate} conn/s");
+            Console.WriteLine($"Connection hold: {Hold} ms");
+        }
+
+        /// <summary>Record the storm settings as benchmark parameters</summary>
+        public void Describe(BenchmarkResult result)
+        {
+            result
+                .Parameter("address", Address)
+                .Parameter("port", Port)
+                .Parameter("threads", Threads)
+                .Parameter("clients", Clients)
+                .Parameter("rate", Rate)
+                .Parameter("hold", Hold)
+                .Parameter("seconds", Seconds)
+                .Parameter("warmup", Warmup)
+                .Parameter("external", External);
+        }
+
+        /// <summary>Add the client to the storm</summary>
+        public void Add(IStormClient client)
+        {
+            _clients.Add(client);
+            Idle.Enqueue(client);
+        }
+
+        /// <summary>Record the connect latency from the intended connect time after the warm-up</summary>
+        public void RecordConnect(long timestamp)
+        {
+            Interlocked.Increment(ref TotalConnects);
+            Record(ConnectLatency, timestamp);
+        }
+
+        /// <summary>Record the latency from the intended connect time after the warm-up</summary>
+        public void Record(LatencyHistogram histogram, long timestamp)
+        {
+            if (timestamp >= _warmupTimestamp)
+                histogram.Record((long)((Stopwatch.GetTimestamp() - timestamp) * (1000000000.0 / Stopwatch.Frequency)));
+        }
+
+        /// <summary>Close the established connection immediately or after the hold time</summary>
+        public void Established(IStormClient client)
+        {
+            if (_holding)
+                return;
+
+            if (_holdTicks > 0)
+                _held.Enqueue(new KeyValuePair<IStormClient, long>(client, Stopwatch.GetTimestamp() + _holdTicks));
+            else
+                client.DisconnectAsync();
+        }
+
+        /// <summary>Measure memory per connection with all clients connected at once</summary>
+        /// <remarks>
+        /// Clients and the in-process server share the process, so the result
+        /// is the client and the server side of one connection together.
+        /// </remarks>
+        public void MeasureMemory(Func<long> connected)
+        {
+            _holding = true;
+            long managedBefore = GC.GetTotalMemory(true);
+            long privateBefore = Process.GetCurrentProcess().PrivateMemorySize64;
+            while (Idle.TryDequeue(out IStormClient client))
+                Connect(client, 0);
+            long count;
+            var deadline = DateTime.UtcNow.AddSeconds(30);
+            do
+            {
+                Thread.Sleep(10);
+                count = connected();
+            } while ((count < Clients) && (DateTime.UtcNow < deadline));
+            long managedAfter = GC.GetTotalMemory(true);
+            long privateAfter = Process.GetCurrentProcess().PrivateMemorySize64;
+            count = Math.Max(count, 1);
+            MemoryManaged = (double)(managedAfter - managedBefore) / count;
+            MemoryPrivate = (double)(privateAfter - privateBefore) / count;
+            _holding = false;
+            foreach (var client in _clients)
+                client.DisconnectAsync();
+            while (Idle.Count < _clients.Count)
+                Thread.Yield();
+
+            // Reset counters after the memory measurement
+            TotalConnects = 0;
+            TotalErrors = 0;
+            ConnectLatency.Reset();
+        }
+
+        /// <summary>Run the storm</summary>
+        /// <param name="acceptRate">Sample the server accept rate once per second (null if the server is external)</param>
+        /// <param name="tick">Called on each loop iteration with the current timestamp (could be null)</param>
+        public void Run(Func<double> acceptRate, Action<long> tick)
+        {
+            var cpuStart = Process.GetCurrentProcess().TotalProcessorTime;
+            Start = Stopwatch.GetTimestamp();
+            long stop = Start + Seconds * Stopwatch.Frequency;
+            long sample = Start + Stopwatch.Frequency;
+            double interval = (double)Stopwatch.Frequency / Rate;
+            _warmupTimestamp = Start + Warmup * Stopwatch.Frequency;
+            _holdTicks = Hold * Stopwatch.Frequency / 1000;
+
+            long scheduled = 0;
+            while (true)
+            {
+                long now = Stopwatch.GetTimestamp();
+                if (now >= stop)
+                    break;
+
+                // Close held connections which are due by now
+                while (_held.TryPeek(out KeyValuePair<IStormClient, long> held) && (held.Value <= now) && _held.TryDequeue(out held))
+                    held.Key.DisconnectAsync();
+
+                // Open all connections due by now from their intended connect time
+                for (long intended = Start + (long)(scheduled * interval); intended <= now; intended = Start + (long)(scheduled * interval))
+                {
+                    if (Idle.TryDequeue(out IStormClient client))
+                        Connect(client, intended);
+                    else
+                        ++Skipped;
+                    ++scheduled;
+                }
+
+                // Sample the server accept rate once per second
+                if ((acceptRate != null) && (now >= sample))
+                {
+                    double rate = acceptRate();
+                    if (now >= _warmupTimestamp)
+                        AcceptRatePeak = Math.Max(AcceptRatePeak, rate);
+                    sample += Stopwatch.Frequency;
+                }
+
+                tick?.Invoke(now);
+
+                // Sleep only if the next connection is far enough
+                long wait = Start + (long)(scheduled * interval) - Stopwatch.GetTimestamp();
+                if (wait > 2 * Stopwatch.Frequency / 1000)
+                    Thread.Sleep(1);
+                else if (wait > 0)
+                    Thread.SpinWait(16);
+            }
+
+            CpuTime = Process.GetCurrentProcess().TotalProcessorTime - cpuStart;
+            Connects = Interlocked.Read(ref TotalConnects);
+        }
+
+        /// <summary>Close all remaining connections</summary>
+        public void CloseAll()
+        {
+            while (_held.TryDequeue(out KeyValuePair<IStormClient, long> held))
+                held.Key.DisconnectAsync();
+            foreach (var client in _clients)
+                client.DisconnectAsync();
+            Thread.Sleep(1000);
+        }
+
+        /// <summary>Print the latency histogram</summary>
+        public static void Report(string name, LatencyHistogram histogram)
+        {
+            Console.WriteLine($"{name} samples: {histogram.TotalCount}");
+            if (histogram.TotalCount > 0)
+            {
+                Console.WriteLine($"{name} min: {Service.GenerateTimePeriod(histogram.Min / 1000000.0)}");
+                Console.WriteLine($"{name} mean: {Service.GenerateTimePeriod(histogram.Mean / 1000000.0)}");
+                Console.WriteLine($"{name} p50: {Service.GenerateTimePeriod(histogram.ValueAtPercentile(50) / 1000000.0)}");
+                Console.WriteLine($"{name} p90: {Service.GenerateTimePeriod(histogram.ValueAtPercentile(90) / 1000000.0)}");
+                Console.WriteLine($"{name} p99: {Service.GenerateTimePeriod(histogram.ValueAtPercentile(99) / 1000000.0)}");
+                Console.WriteLine($"{name} p99.9: {Service.GenerateTimePeriod(histogram.ValueAtPercentile(99.9) / 1000000.0)}");
+                Console.WriteLine($"{name} max: {Service.GenerateTimePeriod(histogram.Max / 1000000.0)}");
+            }
+        }
+
+        private void Connect(IStormClient client, long timestamp)
+        {
+            if (!client.Connect(timestamp))
+                Idle.Enqueue(client);
+        }
+
+        private readonly List<IStormClient> _clients = new List<IStormClient>();
+        private readonly ConcurrentQueue<KeyValuePair<IStormClient, long>> _held = new ConcurrentQueue<KeyValuePair<IStormClient, long>>();
+        private long _warmupTimestamp;
+        private long _holdTicks;
+        private volatile bool _holding;
+    }
+}
@@ -0,0 +1,185 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Threading;
+using CSharpServer;
+using NDesk.Options;
+
+namespace CSharpServer.Benchmarks
+{
+    /// <summary>
+    /// Echo client driven by the open-loop schedule.
+    /// </summary>
+    public interface IOpenLoopClient
+    {
+        /// <summary>Send the message stamped with its intended send time</summary>
+        void SendScheduled(long timestamp);
+    }
+
+    /// <summary>
+    /// Round-trip latency and open-loop fixed-rate mode shared by echo clients.
+    /// Messages carry their send timestamp in the first 8 bytes, so latency is
+    /// not measured for messages shorter than that. In open-loop mode messages
+    /// are sent on a fixed schedule independent of responses and stamped with
+    /// their intended send time, so queueing delay is not hidden.
+    /// </summary>
+    public class OpenLoop
+    {
+        /// <summary>Total target rate in messages per second (0 to disable)</summary>
+        public long Rate { get; set; }
+        /// <summary>Target rates sweep as FROM:TO:STEP (null to disable)</summary>
+        public string Sweep { get; set; }
+
+        /// <summary>Target rates to run</summary>
+        public List<long> Rates { get; } = new List<long>();
+        /// <summary>Is the open-loop mode enabled?</summary>
+        public bool Enabled => Rates.Count > 0;
+
+        /// <summary>Round-trip latency of messages sent after the warm-up</summary>
+        public LatencyHistogram Latency { get; } = new LatencyHistogram();
+        /// <summary>Open-loop metrics to record into the benchmark result</summary>
+        public List<KeyValuePair<string, double>> Metrics { get; } = new List<KeyValuePair<string, double>>();
+        /// <summary>Messages sent before this timestamp are not recorded</summary>
+        public long WarmupTimestamp { get; set; }
+
+        /// <summary>Add open-loop options to the command line option set</summary>
+        public void AddOptions(OptionSet options)
+        {
+            options.Add("r|rate=", "send N messages per second in total", v => Rate = long.Parse(v));
+            options.Add("sweep=", "sweep target rates as FROM:TO:STEP to find the saturation knee", v => Sweep = v);
+        }
+
+        /// <summary>Prepare target rates from the parsed options</summary>
+        public void Prepare()
+        {
+            Rates.Clear();
+            if (Sweep != null)
+            {
+                var parts = Sweep.Split(':');
+                long from = long.Parse(parts[0]);
+                long to = long.Parse(parts[1]);
+                long step = (parts.Length > 2) ? long.Parse(parts[2]) : from;
+                for (long r = from; (r <= to) && (step > 0); r += step)
+                    Rates.Add(r);
+            }
+            else if (Rate > 0)
+                Rates.Add(Rate);
+        }
+
+        /// <summary>Record the open-loop settings and metrics into the benchmark result</summary>
+        public void Describe(BenchmarkResult result)
+        {
+            result
+                .Parameter("rate", Rate)
+                .Parameter("sweep", Sweep ?? "");
+            foreach (var metric in Metrics)
+                result.Metric(metric.Key, metric.Value);
+        }
+
+        /// <summary>Embed the high-resolution send timestamp into the message</summary>
+        public static void StampMessage(byte[] message, long timestamp)
+        {
+            if (message.Length < sizeof(long))
+                return;
+
+            for (int i = 0; i < sizeof(long); ++i)
+                message[i] = (byte)(timestamp >> (i * 8));
+        }
+
+        /// <summary>Record the round-trip time of the message sent after the warm-up</summary>
+        public void RecordLatency(byte[] stamp, long offset)
+        {
+            if (stamp.Length < offset + sizeof(long))
+                return;
+
+            long timestamp = 0;
+            for (int i = 0; i < sizeof(long); ++i)
+                timestamp |= (long)stamp[offset + i] << (i * 8);
+
+            if (timestamp >= WarmupTimestamp)
+                Latency.Record((long)((Stopwatch.GetTimestamp() - timestamp) * (1000000000.0 / Stopwatch.Frequency)));
+        }
+
+        /// <summary>Send messages at each target rate and find the saturation knee</summary>
+        public void Run(IReadOnlyList<IOpenLoopClient> clients, int seconds, int warmup)
+        {
+            Console.WriteLine("Open-loop benchmarking...");
+            Console.WriteLine();
+            Console.WriteLine("Target rate | Throughput | p50 | p90 | p99 | p99.9 | max" + Columns);
+
+            long baseline = 0;
+            long knee = 0;
+            foreach (var rate in Rates)
+            {
+                Latency.Reset();
+                OnRateStarting(clients, rate);
+
+                long start = Stopwatch.GetTimestamp();
+                long stop = start + seconds * Stopwatch.Frequency;
+                double interval = (double)Stopwatch.Frequency / rate;
+                WarmupTimestamp = start + warmup * Stopwatch.Frequency;
+
+                long scheduled = 0;
+                int next = 0;
+                while (true)
+                {
+                    long now = Stopwatch.GetTimestamp();
+                    if (now >= stop)
+                        break;
+
+                    // Send all messages due by now stamped with their intended send time
+                    for (long intended = start + (long)(scheduled * interval); intended <= now; intended = start + (long)(scheduled * interval))
+                    {
+                        clients[next].SendScheduled(intended);
+                        next = (next + 1) % clients.Count;
+                        ++scheduled;
+                    }
+
+                    // Sleep only if the next message is far enough
+                    long wait = start + (long)(scheduled * interval) - Stopwatch.GetTimestamp();
+                    if (wait > 2 * Stopwatch.Frequency / 1000)
+                        Thread.Sleep(1);
+                    else if (wait > 0)
+                        Thread.SpinWait(16);
+                }
+
+                // Wait for in-flight responses
+                Thread.Sleep(1000);
+
+                double measured = Math.Max(seconds - warmup, 1);
+                double throughput = Latency.TotalCount / measured;
+                long p99 = Latency.ValueAtPercentile(99);
+                string columns = OnRateFinished(clients, rate);
+                Console.WriteLine($"{rate} msg/s | {(long)throughput} msg/s | {Service.GenerateTimePeriod(Latency.ValueAtPercentile(50) / 1000000.0)} | {Service.GenerateTimePeriod(Latency.ValueAtPercentile(90) / 1000000.0)} | {Service.GenerateTimePeriod(p99 / 1000000.0)} | {Service.GenerateTimePeriod(Latency.ValueAtPercentile(99.9) / 1000000.0)} | {Service.GenerateTimePeriod(Latency.Max / 1000000.0)}{columns}");
+
+                // Saturation knee is the first rate that is not sustained or explodes the tail latency
+                if (baseline == 0)
+                    baseline = Math.Max(p99, 1);
+                if ((knee == 0) && ((throughput < 0.95 * rate) || (p99 > 10 * baseline)))
+                    knee = rate;
+
+                Metrics.Add(new KeyValuePair<string, double>($"openloop.{rate}.throughput", throughput));
+                Metrics.Add(new KeyValuePair<string, double>($"openloop.{rate}.p50", Latency.ValueAtPercentile(50)));
+                Metrics.Add(new KeyValuePair<string, double>($"openloop.{rate}.p99", p99));
+                Metrics.Add(new KeyValuePair<string, double>($"openloop.{rate}.p99.9", Latency.ValueAtPercentile(99.9)));
+            }
+
+            Metrics.Add(new KeyValuePair<string, double>("openloop.knee", knee));
+
+            Console.WriteLine();
+            if (knee > 0)
+                Console.WriteLine($"Saturation knee: {knee} msg/s");
+            else
+                Console.WriteLine("Saturation knee: not reached");
+        }
+
+        /// <summary>Extra report columns header (each column starts with " | ")</summary>
+        protected virtual string Columns => "";
+
+        /// <summary>Handle the target rate run starting</summary>
+        protected virtual void OnRateStarting(IReadOnlyList<IOpenLoopClient> clients, long rate) {}
+        /// <summary>Handle the target rate run finished</summary>
+        /// <returns>Extra report columns (each column starts with " | ")</returns>
+        protected virtual string OnRateFinished(IReadOnlyList<IOpenLoopClient> clients, long rate) { return ""; }
+    }
+}
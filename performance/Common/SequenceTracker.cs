@@ -0,0 +1,164 @@
+﻿using System;
+using System.Diagnostics;
+using System.Net.NetworkInformation;
+using CSharpServer;
+
+namespace CSharpServer.Benchmarks
+{
+    /// <summary>
+    /// Datagram stream tracker: loss, reordering, duplicates and jitter.
+    /// Datagrams carry the sender timestamp (Stopwatch ticks) at offset 0
+    /// and the sequence number at offset 8, both little-endian.
+    /// Not thread-safe, use one tracker per receiving socket.
+    /// </summary>
+    public class SequenceTracker
+    {
+        /// <summary>Header size required in each datagram</summary>
+        public const int HeaderSize = 2 * sizeof(long);
+
+        /// <summary>Highest received sequence number</summary>
+        public long Highest { get; private set; } = -1;
+        /// <summary>Number of unique received datagrams</summary>
+        public long Received { get; private set; }
+        /// <summary>Number of duplicated datagrams</summary>
+        public long Duplicates { get; private set; }
+        /// <summary>Number of datagrams received after a higher sequence number</summary>
+        public long Reordered { get; private set; }
+        /// <summary>Number of datagrams not received (yet) up to the highest sequence number</summary>
+        public long Lost => Math.Max(Highest - First + 1 - Received, 0);
+        /// <summary>Lost datagrams ratio</summary>
+        public double LossRate => (Highest >= First) ? (double)Lost / (Highest - First + 1) : 0.0;
+        /// <summary>RFC 3550 interarrival jitter estimate in nanoseconds</summary>
+        public double Jitter { get; private set; }
+        /// <summary>Transit time variation histogram in nanoseconds</summary>
+        public LatencyHistogram Variation { get; } = new LatencyHistogram();
+
+        /// <summary>First tracked sequence number</summary>
+        public long First { get; private set; } = -1;
+
+        /// <summary>Write the header into the datagram</summary>
+        public static void Stamp(byte[] datagram, long timestamp, long sequence)
+        {
+            if (datagram.Length < HeaderSize)
+                return;
+
+            for (int i = 0; i < sizeof(long); ++i)
+            {
+                datagram[i] = (byte)(timestamp >> (i * 8));
+                datagram[sizeof(long) + i] = (byte)(sequence >> (i * 8));
+            }
+        }
+
+        /// <summary>Track the received datagram</summary>
+        public void Track(byte[] buffer, long size)
+        {
+            if (size < HeaderSize)
+                return;
+
+            long timestamp = 0;
+            long sequence = 0;
+            for (int i = 0; i < sizeof(long); ++i)
+            {
+                timestamp |= (long)buffer[i] << (i * 8);
+                sequence |= (long)buffer[sizeof(long) + i] << (i * 8);
+            }
+            Track(timestamp, sequence, Stopwatch.GetTimestamp());
+        }
+
+        /// <summary>Track the received datagram with the given header and arrival time</summary>
+        public void Track(long timestamp, long sequence, long arrival)
+        {
+            if (First < 0)
+            {
+                First = sequence;
+                Highest = sequence - 1;
+            }
+            if (sequence < First)
+                return;
+
+            // Duplicates are detected within the sliding window below the highest sequence number
+            long offset = sequence - First;
+            if (offset < Highest - First + 1)
+            {
+                if ((Highest - sequence < Window) && Seen(offset))
+                {
+                    ++Duplicates;
+                    return;
+                }
+                ++Reordered;
+            }
+            else
+            {
+                // Clear window bits skipped by the gap
+                for (long s = Math.Max(Highest + 1, sequence - Window + 1); s < sequence; ++s)
+                    Mark(s - First, false);
+                Highest = sequence;
+            }
+            Mark(offset, true);
+            ++Received;
+
+            // RFC 3550 jitter uses the transit time difference of consecutive datagrams
+            long transit = arrival - timestamp;
+            if (_transit.HasValue)
+            {
+                double delta = Math.Abs(transit - _transit.Value) * (1000000000.0 / Stopwatch.Frequency);
+                Jitter += (delta - Jitter) / 16.0;
+                Variation.Record((long)delta);
+            }
+            _transit = transit;
+        }
+
+        /// <summary>Reset the tracker to start a new measurement</summary>
+        public void Reset()
+        {
+            First = -1;
+            Highest = -1;
+            Received = 0;
+            Duplicates = 0;
+            Reordered = 0;
+            Jitter = 0.0;
+            Variation.Reset();
+            Array.Clear(_window, 0, _window.Length);
+            _transit = null;
+        }
+
+        /// <summary>Merge counters of another tracker into this one (histograms and jitter only)</summary>
+        public void Merge(SequenceTracker other)
+        {
+            Variation.Merge(other.Variation);
+            Jitter = Math.Max(Jitter, other.Jitter);
+        }
+
+        /// <summary>
+        /// System wide UDP receive errors counter. Includes datagrams dropped
+        /// due to full socket receive buffers. Windows has no per-socket drop
+        /// counter like SO_RXQ_OVFL on Linux.
+        /// </summary>
+        public static long SystemReceiveErrors()
+        {
+            try
+            {
+                var properties = IPGlobalProperties.GetIPGlobalProperties();
+                return properties.GetUdpIPv4Statistics().IncomingDatagramsWithErrors + properties.GetUdpIPv6Statistics().IncomingDatagramsWithErrors;
+            }
+            catch (NetworkInformationException)
+            {
+                return 0;
+            }
+        }
+
+        private const long Window = 64 * 1024;
+
+        private bool Seen(long offset) { return (_window[(offset % Window) >> 6] & (1UL << (int)(offset & 63))) != 0; }
+        private void Mark(long offset, bool value)
+        {
+            if (value)
+                _window[(offset % Window) >> 6] |= 1UL << (int)(offset & 63);
+            else
+                _window[(offset % Window) >> 6] &= ~(1UL << (int)(offset & 63));
+        }
+
+        private readonly ulong[] _window = new ulong[Window / 64];
+        private long? _transit;
+    }
+}
@@ -0,0 +1,66 @@
+﻿using System;
+using CSharpServer;
+using NDesk.Options;
+
+namespace CSharpServer.Benchmarks
+{
+    /// <summary>
+    /// SSL protocol, cipher and key exchange settings shared by SSL benchmarks.
+    /// Server and client of the same benchmark run should use the same settings.
+    /// </summary>
+    public class SslSuite
+    {
+        /// <summary>SSL method</summary>
+        public SslMethod Method { get; set; } = SslMethod.TLSV12;
+        /// <summary>TLS 1.2 cipher list (null to keep OpenSSL defaults)</summary>
+        public string Ciphers { get; set; }
+        /// <summary>TLS 1.3 cipher suites (null to keep OpenSSL defaults)</summary>
+        public string Suites { get; set; }
+        /// <summary>Key exchange groups (null to keep OpenSSL defaults)</summary>
+        public string Groups { get; set; }
+        /// <summary>Application protocols (null to disable ALPN)</summary>
+        public string Alpn { get; set; }
+
+        /// <summary>Add SSL suite options to the command line option set</summary>
+        public void AddOptions(OptionSet options)
+        {
+            options.Add("method=", "SSL method (e.g. TLSV12, TLS)", v => Method = (SslMethod)Enum.Parse(typeof(SslMethod), v, true));
+            options.Add("ciphers=", "TLS 1.2 cipher list (e.g. ECDHE-RSA-AES128-GCM-SHA256)", v => Ciphers = v);
+            options.Add("suites=", "TLS 1.3 cipher suites (e.g. TLS_CHACHA20_POLY1305_SHA256)", v => Suites = v);
+            options.Add("groups=", "key exchange groups (e.g. X25519:P-256)", v => Groups = v);
+            options.Add("alpn=", "comma separated application protocols (e.g. h2,http/1.1)", v => Alpn = v);
+        }
+
+        /// <summary>Create a new SSL context with the suite settings applied</summary>
+        public SslContext CreateContext()
+        {
+            var context = new SslContext(Method);
+            if ((Ciphers != null) && !context.SetCipherList(Ciphers))
+                throw new ArgumentException($"Invalid cipher list: {Ciphers}");
+            if ((Suites != null) && !context.SetCipherSuites(Suites))
+                throw new ArgumentException($"Invalid cipher suites: {Suites}");
+            if ((Groups != null) && !context.SetGroups(Groups))
+                throw new ArgumentException($"Invalid groups: {Groups}");
+            if ((Alpn != null) && !context.SetApplicationProtocols(Alpn.Split(',')))
+                throw new ArgumentException($"Invalid application protocols: {Alpn}");
+            return context;
+        }
+
+        /// <summary>Short description of the suite settings</summary>
+        public override string ToString()
+        {
+            return $"{Method} ciphers={Ciphers ?? "default"} suites={Suites ?? "default"} groups={Groups ?? "default"} alpn={Alpn ?? "none"}";
+        }
+
+        /// <summary>Record the suite settings as benchmark parameters</summary>
+        public void Describe(BenchmarkResult result)
+        {
+            result
+                .Parameter("method", Method.ToString())
+                .Parameter("ciphers", Ciphers ?? "")
+                .Parameter("suites", Suites ?? "")
+                .Parameter("groups", Groups ?? "")
+                .Parameter("alpn", Alpn ?? "");
+        }
+    }
+}
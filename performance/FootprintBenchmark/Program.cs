@@ -0,0 +1,464 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Globalization;
+using System.Reflection;
+using System.Threading;
+using CSharpServer;
+using CSharpServer.Benchmarks;
+using NDesk.Options;
+
+namespace FootprintBenchmark
+{
+    class FootprintTcpSession : TcpSession
+    {
+        public FootprintTcpSession(TcpServer server) : base(server) {}
+
+        protected override void OnReceived(byte[] buffer, long size)
+        {
+            Interlocked.Increment(ref Program.TotalMessages);
+            SendAsync(buffer, 0, size);
+        }
+    }
+
+    class FootprintTcpServer : TcpServer
+    {
+        public FootprintTcpServer(Service service, int port) : base(service, port) {}
+
+        protected override TcpSession CreateSession() { return new FootprintTcpSession(this); }
+    }
+
+    class FootprintSslSession : SslSession
+    {
+        public FootprintSslSession(SslServer server) : base(server) {}
+
+        protected override void OnReceived(byte[] buffer, long size)
+        {
+            Interlocked.Increment(ref Program.TotalMessages);
+            SendAsync(buffer, 0, size);
+        }
+    }
+
+    class FootprintSslServer : SslServer
+    {
+        public FootprintSslServer(Service service, SslContext context, int port) : base(service, context, port) {}
+
+        protected override SslSession CreateSession() { return new FootprintSslSession(this); }
+    }
+
+    class FootprintUdpServer : UdpServer
+    {
+        public FootprintUdpServer(Service service, int port) : base(service, port, InternetProtocol.IPv4) {}
+
+        protected override void OnStarted()
+        {
+            ReceiveAsync();
+        }
+
+        protected override void OnReceived(UdpEndpoint endpoint, byte[] buffer, long size)
+        {
+            if (size == 0)
+            {
+                ReceiveAsync();
+                return;
+            }
+
+            Interlocked.Increment(ref Program.TotalMessages);
+            SendAsync(endpoint, buffer, 0, size);
+        }
+
+        protected override void OnSent(UdpEndpoint endpoint, long sent)
+        {
+            ReceiveAsync();
+        }
+    }
+
+    class FootprintTcpClient : TcpClient
+    {
+        public FootprintTcpClient(Service service, string address, int port) : base(service, address, port) {}
+
+        protected override void OnReceived(byte[] buffer, long size)
+        {
+            Interlocked.Increment(ref Program.TotalMessages);
+            if (Program.Active)
+                SendAsync(buffer, 0, size);
+        }
+    }
+
+    class FootprintSslClient : SslClient
+    {
+        public FootprintSslClient(Service service, SslContext context, string address, int port) : base(service, context, address, port) {}
+
+        protected override void OnReceived(byte[] buffer, long size)
+        {
+            Interlocked.Increment(ref Program.TotalMessages);
+            if (Program.Active)
+                SendAsync(buffer, 0, size);
+        }
+    }
+
+    class FootprintUdpClient : UdpClient
+    {
+        public FootprintUdpClient(Service service, string address, int port) : base(service, address, port) {}
+
+        protected override void OnConnected()
+        {
+            ReceiveAsync();
+            // Let the server see this client
+            SendAsync(Program.MessageToSend);
+        }
+
+        protected override void OnReceived(UdpEndpoint endpoint, byte[] buffer, long size)
+        {
+            Interlocked.Increment(ref Program.TotalMessages);
+            if (Program.Active)
+                SendAsync(buffer, 0, size);
+            ReceiveAsync();
+        }
+    }
+
+    // Process footprint sample
+    struct Footprint
+    {
+        public long Managed;
+        public long Private;
+        public long Handles;
+
+        public static Footprint Take()
+        {
+            var process = Process.GetCurrentProcess();
+            return new Footprint { Managed = GC.GetTotalMemory(true), Private = process.PrivateMemorySize64, Handles = process.HandleCount };
+        }
+
+        public override string ToString() { return $"{Managed} {Private} {Handles}"; }
+
+        public static Footprint Parse(string[] parts, int index)
+        {
+            return new Footprint { Managed = long.Parse(parts[index]), Private = long.Parse(parts[index + 1]), Handles = long.Parse(parts[index + 2]) };
+        }
+    }
+
+    class Program
+    {
+        public static byte[] MessageToSend;
+        public static volatile bool Active;
+        public static long TotalMessages;
+
+        // Server listens on all addresses, so clients are spread over destination loopback addresses
+        static string ServerAddress(int index, int spread) { return $"127.0.0.{1 + index % Math.Max(spread, 1)}"; }
+
+        // Read the client process reply, null if the client process has exited
+        static string[] ReadReply(Process child, string reply)
+        {
+            string line;
+            while ((line = child.StandardOutput.ReadLine()) != null)
+                if (line.StartsWith(reply + " "))
+                    return line.Split(' ');
+
+            child.WaitForExit();
+            Console.WriteLine();
+            Console.WriteLine($"Client process failed with exit code {child.ExitCode}");
+            return null;
+        }
+
+        static SslContext CreateClientContext()
+        {
+            var context = new SslContext(SslMethod.TLSV12);
+            context.SetDefaultVerifyPaths();
+            context.SetRootCerts();
+            context.SetVerifyMode(SslVerifyMode.VerifyPeer | SslVerifyMode.VerifyFailIfNoPeerCert);
+            context.LoadVerifyFile("ca.pem");
+            return context;
+        }
+
+        static SslContext CreateServerContext()
+        {
+            var context = new SslContext(SslMethod.TLSV12);
+            context.SetPassword("qwerty");
+            context.UseCertificateChainFile("server.pem");
+            context.UsePrivateKeyFile("server.pem", SslFileFormat.PEM);
+            context.UseTmpDHFile("dh4096.pem");
+            return context;
+        }
+
+        // Client process: connect all clients, report own footprint and follow parent commands
+        static void RunClients(string transport, int port, int threads, int sessions, int spread)
+        {
+            var service = new Service(threads);
+            service.Start();
+
+            var baseline = Footprint.Take();
+
+            var context = (transport == "ssl") ? CreateClientContext() : null;
+            var clients = new List<object>();
+            for (int i = 0; i < sessions; ++i)
+            {
+                switch (transport)
+                {
+                    case "tcp": { var client = new FootprintTcpClient(service, ServerAddress(i, spread), port); client.ConnectAsync(); clients.Add(client); break; }
+                    case "ssl": { var client = new FootprintSslClient(service, context, ServerAddress(i, spread), port); client.ConnectAsync(); clients.Add(client); break; }
+                    case "udp": { var client = new FootprintUdpClient(service, ServerAddress(i, spread), port); client.ConnectAsync(); clients.Add(client); break; }
+                }
+            }
+
+            string command;
+            while ((command = Console.ReadLine()) != null)
+            {
+                if (command == "footprint")
+                    Console.WriteLine($"FOOTPRINT {baseline} {Footprint.Take()}");
+                else if (command == "active")
+                {
+                    // Start one message ping-pong per client
+                    int[] collections = { GC.CollectionCount(0), GC.CollectionCount(1), GC.CollectionCount(2) };
+                    Interlocked.Exchange(ref TotalMessages, 0);
+                    Active = true;
+                    foreach (var client in clients)
+                    {
+                        if (client is TcpClient tcp)
+                            tcp.SendAsync(MessageToSend);
+                        else if (client is SslClient ssl)
+                            ssl.SendAsync(MessageToSend);
+                        else if (client is UdpClient udp)
+                            udp.SendAsync(MessageToSend);
+                    }
+                    Console.ReadLine();
+                    Active = false;
+                    Console.WriteLine($"ACTIVE {Interlocked.Read(ref TotalMessages)} {GC.CollectionCount(0) - collections[0]} {GC.CollectionCount(1) - collections[1]} {GC.CollectionCount(2) - collections[2]}");
+                }
+                else if (command == "quit")
+                    break;
+            }
+
+            service.Stop();
+        }
+
+        static void Main(string[] args)
+        {
+            bool help = false;
+            string transport = "tcp";
+            int port = 1111;
+            int threads = Environment.ProcessorCount;
+            int sessions = 10000;
+            int spread = 1;
+            int size = 32;
+            int seconds = 10;
+            bool client = false;
+            string json = null;
+
+            var options = new OptionSet()
+            {
+                { "h|?|help",   v => help = v != null },
+                { "x|transport=", v => transport = v.ToLowerInvariant() },
+                { "p|port=", v => port = int.Parse(v) },
+                { "t|threads=", v => threads = int.Parse(v) },
+                { "n|sessions=", v => sessions = int.Parse(v) },
+                { "spread=", v => spread = int.Parse(v) },
+                { "s|size=", v => size = int.Parse(v) },
+                { "z|seconds=", v => seconds = int.Parse(v) },
+                { "client", v => client = v != null },
+                { "json=", v => json = v }
+            };
+
+            try
+            {
+                options.Parse(args);
+            }
+            catch (OptionException e)
+            {
+                Console.Write("Command line error: ");
+                Console.WriteLine(e.Message);
+                Console.WriteLine("Try `--help' to get usage information.");
+                return;
+            }
+
+            if (help || ((transport != "tcp") && (transport != "ssl") && (transport != "udp")))
+            {
+                Console.WriteLine("Usage:");
+                options.WriteOptionDescriptions(Console.Out);
+                Console.WriteLine();
+                Console.WriteLine("Transport is one of: tcp, ssl, udp. Clients run in a child process, so");
+                Console.WriteLine("the reported footprint belongs to the server side only.");
+                Console.WriteLine("Use --spread=N to connect clients to 127.0.0.1..127.0.0.N server addresses.");
+                Console.WriteLine("Clients cannot bind their source address, so this lifts the ephemeral");
+                Console.WriteLine("port limit only where the system reuses ports per destination (Linux).");
+                Console.WriteLine("On Windows extend the dynamic port range for 100K sessions instead:");
+                Console.WriteLine("netsh int ipv4 set dynamicport tcp start=1025 num=64510");
+                return;
+            }
+
+            MessageToSend = new byte[size];
+
+            if (client)
+            {
+                RunClients(transport, port, threads, sessions, spread);
+                return;
+            }
+
+            // Capture process CPU time and GC collections from the very beginning
+            var result = (json != null) ? new BenchmarkResult("Footprint") : null;
+
+            Console.WriteLine($"Transport: {transport}");
+            Console.WriteLine($"Server port: {port}");
+            Console.WriteLine($"Working threads: {threads}");
+            Console.WriteLine($"Sessions: {sessions}");
+            Console.WriteLine($"Server addresses: {spread}");
+            Console.WriteLine($"Message size: {size}");
+            Console.WriteLine($"Seconds to benchmarking: {seconds}");
+
+            Console.WriteLine();
+
+            var service = new Service(threads);
+            service.Start();
+
+            // Start the server
+            Func<ServerStats> statistics;
+            Action stop;
+            switch (transport)
+            {
+                case "tcp":
+                {
+                    var server = new FootprintTcpServer(service, port);
+                    server.SetupReuseAddress(true);
+                    server.Start();
+                    statistics = () => { var stats = new ServerStats(); server.GetStatistics(ref stats); return stats; };
+                    stop = () => server.Stop();
+                    break;
+                }
+                case "ssl":
+                {
+                    var server = new FootprintSslServer(service, CreateServerContext(), port);
+                    server.SetupReuseAddress(true);
+                    server.Start();
+                    statistics = () => { var stats = new ServerStats(); server.GetStatistics(ref stats); return stats; };
+                    stop = () => server.Stop();
+                    break;
+                }
+                default:
+                {
+                    var server = new FootprintUdpServer(service, port);
+                    server.SetupReuseAddress(true);
+                    server.Start();
+                    statistics = () => { var stats = new ServerStats(); server.GetStatistics(ref stats); return stats; };
+                    stop = () => server.Stop();
+                    break;
+                }
+            }
+
+            var baseline = Footprint.Take();
+
+            // Start the client process
+            Console.Write("Clients connecting...");
+            var info = new ProcessStartInfo(Assembly.GetExecutingAssembly().Location, $"--client -x {transport} -p {port} -t {threads} -n {sessions} --spread={spread} -s {size}")
+            {
+                UseShellExecute = false,
+                RedirectStandardInput = true,
+                RedirectStandardOutput = true
+            };
+            var child = Process.Start(info);
+
+            // Wait for all sessions (or the first datagram of each UDP client)
+            var deadline = DateTime.UtcNow.AddSeconds(60 + sessions / 1000);
+            ServerStats current;
+            do
+            {
+                Thread.Sleep(100);
+                current = statistics();
+            } while ((((transport == "udp") ? current.DatagramsReceived : current.ConnectedSessions) < sessions) && (DateTime.UtcNow < deadline));
+            long connected = (transport == "udp") ? Math.Min(current.DatagramsReceived, sessions) : current.ConnectedSessions;
+            Console.WriteLine("Done!");
+
+            // Idle footprint
+            var idle = Footprint.Take();
+            child.StandardInput.WriteLine("footprint");
+            var parts = ReadReply(child, "FOOTPRINT");
+            if (parts == null)
+            {
+                stop();
+                service.Stop();
+                return;
+            }
+            var clientBaseline = Footprint.Parse(parts, 1);
+            var clientIdle = Footprint.Parse(parts, 4);
+
+            // Active footprint with one message in flight per session
+            Console.Write("Benchmarking...");
+            int[] collections = { GC.CollectionCount(0), GC.CollectionCount(1), GC.CollectionCount(2) };
+            Interlocked.Exchange(ref TotalMessages, 0);
+            child.StandardInput.WriteLine("active");
+            Thread.Sleep(seconds * 1000);
+            long messages = Interlocked.Read(ref TotalMessages);
+            double[] gc = { GC.CollectionCount(0) - collections[0], GC.CollectionCount(1) - collections[1], GC.CollectionCount(2) - collections[2] };
+            // Take the active footprint last, it forces a full collection
+            var active = Footprint.Take();
+            child.StandardInput.WriteLine("stop");
+            parts = ReadReply(child, "ACTIVE");
+            if (parts == null)
+            {
+                stop();
+                service.Stop();
+                return;
+            }
+            long clientMessages = long.Parse(parts[1]);
+            double[] clientGC = { double.Parse(parts[2], CultureInfo.InvariantCulture), double.Parse(parts[3], CultureInfo.InvariantCulture), double.Parse(parts[4], CultureInfo.InvariantCulture) };
+            Console.WriteLine("Done!");
+
+            child.StandardInput.WriteLine("quit");
+            child.WaitForExit();
+
+            stop();
+            service.Stop();
+
+            Console.WriteLine();
+
+            long per = Math.Max(connected, 1);
+            double million = Math.Max(messages, 1) / 1000000.0;
+            double clientMillion = Math.Max(clientMessages, 1) / 1000000.0;
+
+            Console.WriteLine($"Connected sessions: {connected}");
+            Console.WriteLine($"Messages (server): {messages}");
+            Console.WriteLine();
+            Console.WriteLine($"Server managed heap per session (idle): {Service.GenerateDataSize((idle.Managed - baseline.Managed) / per)}");
+            Console.WriteLine($"Server private bytes per session (idle): {Service.GenerateDataSize((idle.Private - baseline.Private) / per)}");
+            Console.WriteLine($"Server native heap per session (idle): {Service.GenerateDataSize(((idle.Private - idle.Managed) - (baseline.Private - baseline.Managed)) / per)}");
+            Console.WriteLine($"Server handles per session (idle): {(double)(idle.Handles - baseline.Handles) / per:F2}");
+            Console.WriteLine($"Server managed heap per session (active): {Service.GenerateDataSize((active.Managed - baseline.Managed) / per)}");
+            Console.WriteLine($"Server private bytes per session (active): {Service.GenerateDataSize((active.Private - baseline.Private) / per)}");
+            Console.WriteLine($"Server Gen0/Gen1/Gen2 per 1M messages: {gc[0] / million:F2} / {gc[1] / million:F2} / {gc[2] / million:F2}");
+            Console.WriteLine();
+            Console.WriteLine($"Client managed heap per client (idle): {Service.GenerateDataSize((clientIdle.Managed - clientBaseline.Managed) / per)}");
+            Console.WriteLine($"Client private bytes per client (idle): {Service.GenerateDataSize((clientIdle.Private - clientBaseline.Private) / per)}");
+            Console.WriteLine($"Client handles per client (idle): {(double)(clientIdle.Handles - clientBaseline.Handles) / per:F2}");
+            Console.WriteLine($"Client Gen0/Gen1/Gen2 per 1M messages: {clientGC[0] / clientMillion:F2} / {clientGC[1] / clientMillion:F2} / {clientGC[2] / clientMillion:F2}");
+
+            if (json != null)
+            {
+                result
+                    .Parameter("transport", transport)
+                    .Parameter("port", port)
+                    .Parameter("threads", threads)
+                    .Parameter("sessions", sessions)
+                    .Parameter("spread", spread)
+                    .Parameter("size", size)
+                    .Parameter("seconds", seconds)
+                    .Metric("sessions.connected", connected)
+                    .Metric("throughput.messages", messages / (double)seconds)
+                    .Metric("server.idle.managed", (double)(idle.Managed - baseline.Managed) / per)
+                    .Metric("server.idle.private", (double)(idle.Private - baseline.Private) / per)
+                    .Metric("server.idle.native", (double)((idle.Private - idle.Managed) - (baseline.Private - baseline.Managed)) / per)
+                    .Metric("server.idle.handles", (double)(idle.Handles - baseline.Handles) / per)
+                    .Metric("server.active.managed", (double)(active.Managed - baseline.Managed) / per)
+                    .Metric("server.active.private", (double)(active.Private - baseline.Private) / per)
+                    .Metric("server.gc.gen0.per1m", gc[0] / million)
+                    .Metric("server.gc.gen1.per1m", gc[1] / million)
+                    .Metric("server.gc.gen2.per1m", gc[2] / million)
+                    .Metric("client.idle.managed", (double)(clientIdle.Managed - clientBaseline.Managed) / per)
+                    .Metric("client.idle.private", (double)(clientIdle.Private - clientBaseline.Private) / per)
+                    .Metric("client.idle.handles", (double)(clientIdle.Handles - clientBaseline.Handles) / per)
+                    .Metric("client.gc.gen0.per1m", clientGC[0] / clientMillion)
+                    .Metric("client.gc.gen1.per1m", clientGC[1] / clientMillion)
+                    .Metric("client.gc.gen2.per1m", clientGC[2] / clientMillion)
+                    .Write(json);
+            }
+        }
+    }
+}
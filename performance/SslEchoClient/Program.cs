@@ -1,20 +1,28 @@
 ﻿using System;
 using System.Collections.Generic;
+using System.Diagnostics;
 using System.Threading;
 using CSharpServer;
+using CSharpServer.Benchmarks;
 using NDesk.Options;
 
 namespace SslEchoClient
 {
-    class EchoClient : SslClient
+    class EchoClient : SslClient, IOpenLoopClient
     {
         public EchoClient(Service service, SslContext context, string address, int port, int messages) : base(service, context, address, port)
         {
             _messages = messages;
+            _message = (byte[])Program.MessageToSend.Clone();
+            _scheduled = (byte[])Program.MessageToSend.Clone();
+            _stamp = new byte[Math.Min(sizeof(long), _message.Length)];
         }
 
         protected override void OnHandshaked()
         {
+            if (Program.OpenLoop.Enabled)
+                return;
+
             for (long i = _messages; i > 0; --i)
                 SendMessage();
         }
@@ -26,11 +34,22 @@ namespace SslEchoClient
 
         protected override void OnReceived(byte[] buffer, long size)
         {
-            _received += size;
-            while (_received >= Program.MessageToSend.Length)
+            // Reassemble echoed messages to find their send timestamps
+            for (long offset = 0; offset < size;)
             {
-                SendMessage();
-                _received -= Program.MessageToSend.Length;
+                long chunk = Math.Min(size - offset, _message.Length - _received);
+                if (_received < _stamp.Length)
+                    Array.Copy(buffer, offset, _stamp, _received, Math.Min(chunk, _stamp.Length - _received));
+                _received += chunk;
+                offset += chunk;
+
+                if (_received == _message.Length)
+                {
+                    Program.OpenLoop.RecordLatency(_stamp, 0);
+                    if (!Program.OpenLoop.Enabled)
+                        SendMessage();
+                    _received = 0;
+                }
             }
 
             Program.TimestampStop = DateTime.UtcNow;
@@ -45,12 +64,22 @@ namespace SslEchoClient
 
         private void SendMessage()
         {
-            SendAsync(Program.MessageToSend);
+            OpenLoop.StampMessage(_message, Stopwatch.GetTimestamp());
+            SendAsync(_message);
+        }
+
+        public void SendScheduled(long timestamp)
+        {
+            OpenLoop.StampMessage(_scheduled, timestamp);
+            SendAsync(_scheduled);
         }
 
         private long _sent;
         private long _received;
         private long _messages;
+        private byte[] _message;
+        private byte[] _stamp;
+        private byte[] _scheduled;
     }
 
     class Program
@@ -61,6 +90,7 @@ namespace SslEchoClient
         public static long TotalErrors;
         public static long TotalBytes;
         public static long TotalMessages;
+        public static OpenLoop OpenLoop = new OpenLoop();
 
         static void Main(string[] args)
         {
@@ -72,6 +102,9 @@ namespace SslEchoClient
             int messages = 1000;
             int size = 32;
             int seconds = 10;
+            int warmup = 1;
+            string json = null;
+            var suite = new SslSuite();
 
             var options = new OptionSet()
             {
@@ -82,8 +115,12 @@ namespace SslEchoClient
                 { "c|clients=", v => clients = int.Parse(v) },
                 { "m|messages=", v => messages = int.Parse(v) },
                 { "s|size=", v => size = int.Parse(v) },
-                { "z|seconds=", v => seconds = int.Parse(v) }
+                { "z|seconds=", v => seconds = int.Parse(v) },
+                { "w|warmup=", v => warmup = int.Parse(v) },
+                { "json=", v => json = v }
             };
+            OpenLoop.AddOptions(options);
+            suite.AddOptions(options);
 
             try
             {
@@ -104,6 +141,12 @@ namespace SslEchoClient
                 return;
             }
 
+            // Capture process CPU time and GC collections from the very beginning
+            var result = (json != null) ? new BenchmarkResult("SslEcho") : null;
+
+            // Prepare open-loop target rates
+            OpenLoop.Prepare();
+
             Console.WriteLine($"Server address: {address}");
             Console.WriteLine($"Server port: {port}");
             Console.WriteLine($"Working threads: {threads}");
@@ -111,6 +154,12 @@ namespace SslEchoClient
             Console.WriteLine($"Working messages: {messages}");
             Console.WriteLine($"Message size: {size}");
             Console.WriteLine($"Seconds to benchmarking: {seconds}");
+            Console.WriteLine($"Seconds to warm-up: {warmup}");
+            Console.WriteLine($"SSL suite: {suite}");
+            if (OpenLoop.Enabled)
+                Console.WriteLine($"Open-loop rates: {string.Join(", ", OpenLoop.Rates)} msg/s");
+            if (size < sizeof(long))
+                Console.WriteLine($"Message size is less than {sizeof(long)} bytes, latency is not measured!");
 
             Console.WriteLine();
 
@@ -126,7 +175,7 @@ namespace SslEchoClient
             Console.WriteLine("Done!");
 
             // Create and prepare a new SSL client context
-            var context = new SslContext(SslMethod.TLSV12);
+            var context = suite.CreateContext();
             context.SetDefaultVerifyPaths();
             context.SetRootCerts();
             context.SetVerifyMode(SslVerifyMode.VerifyPeer | SslVerifyMode.VerifyFailIfNoPeerCert);
@@ -142,21 +191,34 @@ namespace SslEchoClient
             }
 
             TimestampStart = DateTime.UtcNow;
+            OpenLoop.WarmupTimestamp = Stopwatch.GetTimestamp() + warmup * Stopwatch.Frequency;
 
             // Connect clients
             Console.Write("Clients connecting...");
+            long connectStart = Stopwatch.GetTimestamp();
             foreach (var client in echoClients)
                 client.ConnectAsync();
             Console.WriteLine("Done!");
             foreach (var client in echoClients)
                 while (!client.IsHandshaked)
                     Thread.Yield();
+            // One-shot burst of all clients, use SslHandshakeStorm for the sustained handshake rate
+            double handshakeTime = (double)(Stopwatch.GetTimestamp() - connectStart) / Stopwatch.Frequency;
             Console.WriteLine("All clients connected!");
+            Console.WriteLine($"Negotiated: {echoClients[0].SslVersion} {echoClients[0].Cipher} {echoClients[0].ApplicationProtocol}");
 
-            // Wait for benchmarking
-            Console.Write("Benchmarking...");
-            Thread.Sleep(seconds * 1000);
-            Console.WriteLine("Done!");
+            if (OpenLoop.Enabled)
+            {
+                OpenLoop.Run(echoClients, seconds, warmup);
+                Console.WriteLine();
+            }
+            else
+            {
+                // Wait for benchmarking
+                Console.Write("Benchmarking...");
+                Thread.Sleep(seconds * 1000);
+                Console.WriteLine("Done!");
+            }
 
             // Disconnect clients
             Console.Write("Clients disconnecting...");
@@ -179,6 +241,10 @@ namespace SslEchoClient
 
             Console.WriteLine();
 
+            Console.WriteLine($"Burst handshake time ({clients} clients): {Service.GenerateTimePeriod(handshakeTime * 1000.0)}");
+
+            Console.WriteLine();
+
             TotalMessages = TotalBytes / size;
 
             Console.WriteLine($"Total time: {Service.GenerateTimePeriod((TimestampStop - TimestampStart).TotalMilliseconds)}");
@@ -187,9 +253,46 @@ namespace SslEchoClient
             Console.WriteLine($"Data throughput: {Service.GenerateDataSize((long)(TotalBytes / (TimestampStop - TimestampStart).TotalSeconds))}/s");
             if (TotalMessages > 0)
             {
-                Console.WriteLine($"Message latency: {Service.GenerateTimePeriod((TimestampStop - TimestampStart).TotalMilliseconds / TotalMessages)}");
                 Console.WriteLine($"Message throughput: {(long)(TotalMessages / (TimestampStop - TimestampStart).TotalSeconds)} msg/s");
             }
+
+            Console.WriteLine();
+
+            Console.WriteLine($"Latency samples: {OpenLoop.Latency.TotalCount}");
+            if (OpenLoop.Latency.TotalCount > 0)
+            {
+                Console.WriteLine($"Latency min: {Service.GenerateTimePeriod(OpenLoop.Latency.Min / 1000000.0)}");
+                Console.WriteLine($"Latency mean: {Service.GenerateTimePeriod(OpenLoop.Latency.Mean / 1000000.0)}");
+                Console.WriteLine($"Latency p50: {Service.GenerateTimePeriod(OpenLoop.Latency.ValueAtPercentile(50) / 1000000.0)}");
+                Console.WriteLine($"Latency p90: {Service.GenerateTimePeriod(OpenLoop.Latency.ValueAtPercentile(90) / 1000000.0)}");
+                Console.WriteLine($"Latency p99: {Service.GenerateTimePeriod(OpenLoop.Latency.ValueAtPercentile(99) / 1000000.0)}");
+                Console.WriteLine($"Latency p99.9: {Service.GenerateTimePeriod(OpenLoop.Latency.ValueAtPercentile(99.9) / 1000000.0)}");
+                Console.WriteLine($"Latency max: {Service.GenerateTimePeriod(OpenLoop.Latency.Max / 1000000.0)}");
+            }
+
+            if (json != null)
+            {
+                suite.Describe(result);
+                result
+                    .Parameter("address", address)
+                    .Parameter("port", port)
+                    .Parameter("threads", threads)
+                    .Parameter("clients", clients)
+                    .Parameter("messages", messages)
+                    .Parameter("size", size)
+                    .Parameter("seconds", seconds)
+                    .Parameter("warmup", warmup)
+                    .Metric("errors", TotalErrors)
+                    .Metric("time.handshake.burst", handshakeTime * 1000000000.0)
+                    .Metric("time", (TimestampStop - TimestampStart).TotalMilliseconds * 1000000.0)
+                    .Metric("bytes", TotalBytes)
+                    .Metric("messages", TotalMessages)
+                    .Metric("throughput.bytes", TotalBytes / (TimestampStop - TimestampStart).TotalSeconds)
+                    .Metric("throughput.messages", TotalMessages / (TimestampStop - TimestampStart).TotalSeconds)
+                    .Latency("latency", OpenLoop.Latency);
+                OpenLoop.Describe(result);
+                result.Write(json);
+            }
         }
     }
 }
@@ -1,5 +1,7 @@
 ﻿using System;
+using System.Threading;
 using CSharpServer;
+using CSharpServer.Benchmarks;
 using NDesk.Options;
 
 namespace SslEchoServer
@@ -8,6 +10,13 @@ namespace SslEchoServer
     {
         public EchoSession(SslServer server) : base(server) {}
 
+        protected override void OnHandshaked()
+        {
+            // Report the negotiated parameters once
+            if (Interlocked.Exchange(ref _reported, 1) == 0)
+                Console.WriteLine($"Negotiated: {SslVersion} {Cipher} {ApplicationProtocol}");
+        }
+
         protected override void OnReceived(byte[] buffer, long size)
         {
             // Resend the message back to the client
@@ -18,6 +27,8 @@ namespace SslEchoServer
         {
             Console.WriteLine($"Session caught an error with code {error} and category '{category}': {message}");
         }
+
+        private static int _reported;
     }
 
     class EchoServer : SslServer
@@ -39,6 +50,7 @@ namespace SslEchoServer
             bool help = false;
             int port = 2222;
             int threads = Environment.ProcessorCount;
+            var suite = new SslSuite();
 
             var options = new OptionSet()
             {
@@ -46,6 +58,7 @@ namespace SslEchoServer
                 { "p|port=", v => port = int.Parse(v) },
                 { "t|threads=", v => threads = int.Parse(v) }
             };
+            suite.AddOptions(options);
 
             try
             {
@@ -68,6 +81,7 @@ namespace SslEchoServer
 
             Console.WriteLine($"Server port: {port}");
             Console.WriteLine($"Working threads: {threads}");
+            Console.WriteLine($"SSL suite: {suite}");
 
             Console.WriteLine();
 
@@ -80,14 +94,18 @@ namespace SslEchoServer
             Console.WriteLine("Done!");
 
             // Create and prepare a new SSL server context
-            var context = new SslContext(SslMethod.TLSV12);
-            context.SetPassword("qwerty");
-            context.UseCertificateChainFile("server.pem");
-            context.UsePrivateKeyFile("server.pem", SslFileFormat.PEM);
-            context.UseTmpDHFile("dh4096.pem");
+            Func<SslContext> factory = () =>
+            {
+                var context = suite.CreateContext();
+                context.SetPassword("qwerty");
+                context.UseCertificateChainFile("server.pem");
+                context.UsePrivateKeyFile("server.pem", SslFileFormat.PEM);
+                context.UseTmpDHFile("dh4096.pem");
+                return context;
+            };
 
             // Create a new echo server
-            var server = new EchoServer(service, context, port, InternetProtocol.IPv4);
+            var server = new EchoServer(service, factory(), port, InternetProtocol.IPv4);
             // server.SetupNoDelay(true);
             server.SetupReuseAddress(true);
             server.SetupReusePort(true);
@@ -97,7 +115,11 @@ namespace SslEchoServer
             server.Start();
             Console.WriteLine("Done!");
 
-            Console.WriteLine("Press Enter to stop the server or '!' to restart the server...");
+            // Reload the certificate on change without dropping sessions
+            var watcher = new SslContextWatcher(server, factory, "server.pem");
+            watcher.Start();
+
+            Console.WriteLine("Press Enter to stop the server or '!' to restart the server or '@' to reload the certificate...");
 
             // Perform text input
             for (;;)
@@ -113,8 +135,17 @@ namespace SslEchoServer
                     server.Restart();
                     Console.WriteLine("Done!");
                 }
+
+                // Reload the certificate keeping connected sessions
+                if (line == "@")
+                {
+                    Console.Write("Certificate reloading...");
+                    Console.WriteLine(watcher.Reload() ? "Done!" : "Failed!");
+                }
             }
 
+            watcher.Stop();
+
             // Stop the server
             Console.Write("Server stopping...");
             server.Stop();
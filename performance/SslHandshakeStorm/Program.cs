@@ -0,0 +1,369 @@
+﻿using System;
+using System.Threading;
+using CSharpServer;
+using CSharpServer.Benchmarks;
+using NDesk.Options;
+
+namespace SslHandshakeStorm
+{
+    class StormSession : SslSession
+    {
+        public StormSession(SslServer server) : base(server) {}
+
+        protected override void OnError(int error, string category, string message)
+        {
+            Console.WriteLine($"Session caught an error with code {error} and category '{category}': {message}");
+        }
+    }
+
+    class StormServer : SslServer
+    {
+        public StormServer(Service service, SslContext context, int port) : base(service, context, port) {}
+
+        protected override SslSession CreateSession() { return new StormSession(this); }
+
+        protected override void OnError(int error, string category, string message)
+        {
+            Console.WriteLine($"Server caught an error with code {error} and category '{category}': {message}");
+        }
+    }
+
+    class StormClient : SslClient, IStormClient
+    {
+        public StormClient(Service service, SslContext context, string address, int port) : base(service, context, address, port) {}
+
+        public bool Connect(long timestamp)
+        {
+            _timestamp = timestamp;
+            return ConnectAsync();
+        }
+
+        protected override void OnConnected()
+        {
+            Program.Storm.RecordConnect(_timestamp);
+        }
+
+        protected override void OnHandshaked()
+        {
+            Interlocked.Increment(ref Program.TotalHandshakes);
+            Program.Storm.Record(Program.HandshakeLatency, _timestamp);
+            Program.Storm.Established(this);
+        }
+
+        protected override void OnDisconnected()
+        {
+            Program.Storm.Idle.Enqueue(this);
+        }
+
+        protected override void OnError(int error, string category, string message)
+        {
+            Interlocked.Increment(ref Program.Storm.TotalErrors);
+        }
+
+        private long _timestamp;
+    }
+
+    class Program
+    {
+        public static ConnectionStorm Storm = new ConnectionStorm(2222);
+        public static LatencyHistogram HandshakeLatency = new LatencyHistogram();
+        public static long TotalHandshakes;
+
+        static SslContext CreateServerContext(SslSuite suite)
+        {
+            var context = suite.CreateContext();
+            context.SetPassword("qwerty");
+            context.UseCertificateChainFile("server.pem");
+            context.UsePrivateKeyFile("server.pem", SslFileFormat.PEM);
+            context.UseTmpDHFile("dh4096.pem");
+            return context;
+        }
+
+        static void Main(string[] args)
+        {
+            bool help = false;
+            bool resume = false;
+            bool swap = false;
+            int limit = 0;
+            var suite = new SslSuite();
+
+            var options = new OptionSet()
+            {
+                { "h|?|help",   v => help = v != null },
+                { "m|resume", v => resume = v != null },
+                { "s|swap", v => swap = v != null },
+                { "l|limit=", v => limit = int.Parse(v) }
+            };
+            Storm.AddOptions(options);
+            suite.AddOptions(options);
+
+            try
+            {
+                options.Parse(args);
+            }
+            catch (OptionException e)
+            {
+                Console.Write("Command line error: ");
+                Console.WriteLine(e.Message);
+                Console.WriteLine("Try `--help' to get usage information.");
+                return;
+            }
+
+            if (help)
+            {
+                Console.WriteLine("Usage:");
+                options.WriteOptionDescriptions(Console.Out);
+                Console.WriteLine();
+                Console.WriteLine("Opens and closes --rate SSL connections per second using up to --clients");
+                Console.WriteLine("concurrent clients. Each connection is held for --hold milliseconds.");
+                Console.WriteLine("The server is hosted in-process unless --external is given, in that");
+                Console.WriteLine("case accept rate and memory per connection are not measured. Memory");
+                Console.WriteLine("per connection includes the client and the server side together.");
+                Console.WriteLine("With --resume clients resume SSL sessions instead of full handshakes.");
+                Console.WriteLine("With --swap the in-process server swaps its SSL context in the middle of");
+                Console.WriteLine("the run, sessions established before the swap must still resume.");
+                Console.WriteLine("With --limit the in-process server sheds handshakes above the limit.");
+                return;
+            }
+
+            // Capture process CPU time and GC collections from the very beginning
+            var result = (Storm.Json != null) ? new BenchmarkResult("SslHandshakeStorm") : null;
+
+            Storm.Print();
+            Console.WriteLine($"Session resumption: {resume}");
+            Console.WriteLine($"Context swap: {swap}");
+            Console.WriteLine($"Handshake limit: {limit}");
+            Console.WriteLine($"SSL suite: {suite}");
+            Console.WriteLine($"Seconds to benchmarking: {Storm.Seconds}");
+            Console.WriteLine($"Seconds to warm-up: {Storm.Warmup}");
+
+            Console.WriteLine();
+
+            // Create a new service
+            var service = new Service(Storm.Threads);
+
+            // Start the service
+            Console.Write("Service starting...");
+            service.Start();
+            Console.WriteLine("Done!");
+
+            // Create and prepare a new SSL server context
+            StormServer server = null;
+            SslContext serverContext = null;
+            SslContext swapContext = null;
+            if (!Storm.External)
+            {
+                serverContext = CreateServerContext(suite);
+                if (resume)
+                    serverContext.SetSessionCache(true, Storm.Clients, TimeSpan.FromMinutes(5));
+
+                // Swapped context has neither the session cache nor the session Id context
+                if (swap)
+                {
+                    swapContext = CreateServerContext(suite);
+                    swapContext.SetSessionTickets(false);
+                }
+
+                // Start the in-process server with handshake latency histograms
+                server = new StormServer(service, serverContext, Storm.Port);
+                server.SetupReuseAddress(true);
+                server.SetupLatencyHistograms(true);
+                server.SetupHandshakeLimit(limit);
+                Console.Write("Server starting...");
+                server.Start();
+                Console.WriteLine("Done!");
+            }
+
+            // Create and prepare a new SSL client context
+            var context = suite.CreateContext();
+            context.SetDefaultVerifyPaths();
+            context.SetRootCerts();
+            context.SetVerifyMode(SslVerifyMode.VerifyPeer | SslVerifyMode.VerifyFailIfNoPeerCert);
+            context.LoadVerifyFile("ca.pem");
+
+            // Create storm clients
+            for (int i = 0; i < Storm.Clients; ++i)
+            {
+                var client = new StormClient(service, context, Storm.Address, Storm.Port);
+                client.SetupSessionResumption(resume);
+                Storm.Add(client);
+            }
+
+            // Measure memory per connection with all clients connected at once
+            var serverStats = new ServerStats();
+            if (server != null)
+            {
+                Console.Write("Measuring memory per connection...");
+                Storm.MeasureMemory(() => { server.GetStatistics(ref serverStats); return serverStats.ConnectedSessions; });
+                Console.WriteLine("Done!");
+                server.ResetLatency();
+                server.GetStatistics(ref serverStats);
+            }
+
+            // Reset counters after the memory measurement
+            TotalHandshakes = 0;
+            HandshakeLatency.Reset();
+            long acceptedStart = serverStats.Accepted;
+            long shedStart = serverStats.HandshakesShed;
+            var sessionStart = new SslSessionStats();
+            context.GetSessionStatistics(ref sessionStart);
+            var serverSessionStart = new SslSessionStats();
+            if (serverContext != null)
+                serverContext.GetSessionStatistics(ref serverSessionStart);
+            var swapStart = new SslSessionStats();
+            bool swapped = false;
+
+            Console.Write("Benchmarking...");
+
+            // Swap the server context once in the middle of the run
+            Action<long> tick = null;
+            if (swapContext != null)
+            {
+                tick = now =>
+                {
+                    if (!swapped && (now >= Storm.Start + Storm.Seconds * System.Diagnostics.Stopwatch.Frequency / 2))
+                    {
+                        context.GetSessionStatistics(ref swapStart);
+                        server.SwapContext(swapContext);
+                        swapped = true;
+                    }
+                };
+            }
+            Storm.Run((server != null) ? () => { server.GetStatistics(ref serverStats); return serverStats.AcceptRate; } : (Func<double>)null, tick);
+            long handshakes = Interlocked.Read(ref TotalHandshakes);
+
+            Console.WriteLine("Done!");
+
+            Storm.CloseAll();
+
+            var serverHandshake = new LatencyHistogram();
+            var serverHandshakeWait = new LatencyHistogram();
+            if (server != null)
+            {
+                server.GetStatistics(ref serverStats);
+                server.SnapshotLatency(LatencyKind.Handshake, serverHandshake);
+                server.SnapshotLatency(LatencyKind.HandshakeWait, serverHandshakeWait);
+                Console.Write("Server stopping...");
+                server.Stop();
+                Console.WriteLine("Done!");
+            }
+
+            // Stop the service
+            Console.Write("Service stopping...");
+            service.Stop();
+            Console.WriteLine("Done!");
+
+            Console.WriteLine();
+
+            var sessionStats = new SslSessionStats();
+            context.GetSessionStatistics(ref sessionStats);
+            long resumed = sessionStats.Resumed - sessionStart.Resumed;
+            long full = sessionStats.FullHandshakes - sessionStart.FullHandshakes;
+            long resumedSwap = swapped ? (sessionStats.Resumed - swapStart.Resumed) : 0;
+            long fullSwap = swapped ? (sessionStats.FullHandshakes - swapStart.FullHandshakes) : 0;
+
+            // Server handshakes are counted by the context the server was created with even after the swap
+            var serverSessionStats = new SslSessionStats();
+            if (serverContext != null)
+                serverContext.GetSessionStatistics(ref serverSessionStats);
+            long serverResumed = serverSessionStats.Resumed - serverSessionStart.Resumed;
+            long serverFull = serverSessionStats.FullHandshakes - serverSessionStart.FullHandshakes;
+
+            long connects = Storm.Connects;
+            long accepted = serverStats.Accepted - acceptedStart;
+            long shed = serverStats.HandshakesShed - shedStart;
+            double acceptRate = accepted / (double)Storm.Seconds;
+            double cpuPerHandshake = (handshakes > 0) ? (Storm.CpuTime.TotalMilliseconds * 1000000.0 / handshakes) : 0.0;
+
+            Console.WriteLine($"Errors: {Storm.TotalErrors}");
+
+            Console.WriteLine();
+
+            Console.WriteLine($"Total connects: {connects}");
+            Console.WriteLine($"Total handshakes: {handshakes}");
+            Console.WriteLine($"Skipped connects (no idle client): {Storm.Skipped}");
+            Console.WriteLine($"Handshake rate: {(long)(handshakes / (double)Storm.Seconds)} hs/s");
+            Console.WriteLine($"Resumed handshakes: {resumed}");
+            Console.WriteLine($"Full handshakes: {full}");
+            if (swapped)
+            {
+                Console.WriteLine($"Resumed handshakes after swap: {resumedSwap}");
+                Console.WriteLine($"Full handshakes after swap: {fullSwap}");
+            }
+            if (server != null)
+            {
+                Console.WriteLine($"Server resumed handshakes: {serverResumed}");
+                Console.WriteLine($"Server full handshakes: {serverFull}");
+                Console.WriteLine($"Total accepted: {accepted}");
+                Console.WriteLine($"Accept rate: {(long)acceptRate} conn/s");
+                Console.WriteLine($"Accept rate peak: {(long)Storm.AcceptRatePeak} conn/s");
+                Console.WriteLine($"Handshakes in flight peak: {serverStats.HandshakesPeak}");
+                Console.WriteLine($"Handshakes shed: {shed}");
+                Console.WriteLine($"Memory per connection (client + server, managed): {Service.GenerateDataSize((long)Storm.MemoryManaged)}");
+                Console.WriteLine($"Memory per connection (client + server, private): {Service.GenerateDataSize((long)Storm.MemoryPrivate)}");
+            }
+            Console.WriteLine($"CPU per handshake{(Storm.External ? "" : " (client + server)")}: {Service.GenerateTimePeriod(cpuPerHandshake / 1000000.0)}");
+
+            Console.WriteLine();
+
+            ConnectionStorm.Report("Connect latency", Storm.ConnectLatency);
+
+            Console.WriteLine();
+
+            ConnectionStorm.Report("Handshake latency", HandshakeLatency);
+
+            Console.WriteLine();
+
+            ConnectionStorm.Report("Server handshake latency", serverHandshake);
+
+            Console.WriteLine();
+
+            Console.WriteLine($"Server handshake wait samples: {serverHandshakeWait.TotalCount}");
+            if (serverHandshakeWait.TotalCount > 0)
+            {
+                Console.WriteLine($"Server handshake wait p50: {Service.GenerateTimePeriod(serverHandshakeWait.ValueAtPercentile(50) / 1000000.0)}");
+                Console.WriteLine($"Server handshake wait p99: {Service.GenerateTimePeriod(serverHandshakeWait.ValueAtPercentile(99) / 1000000.0)}");
+                Console.WriteLine($"Server handshake wait max: {Service.GenerateTimePeriod(serverHandshakeWait.Max / 1000000.0)}");
+            }
+
+            if (Storm.Json != null)
+            {
+                Storm.Describe(result);
+                suite.Describe(result);
+                result
+                    .Parameter("resume", resume)
+                    .Parameter("swap", swap)
+                    .Parameter("limit", limit)
+                    .Metric("errors", Storm.TotalErrors)
+                    .Metric("skipped", Storm.Skipped)
+                    .Metric("throughput.handshakes", handshakes / (double)Storm.Seconds)
+                    .Metric("cpu.handshake", cpuPerHandshake)
+                    .Metric("handshakes.resumed", resumed)
+                    .Metric("handshakes.full", full)
+                    .Latency("connect", Storm.ConnectLatency)
+                    .Latency("handshake", HandshakeLatency)
+                    .Latency("server.handshake", serverHandshake)
+                    .Latency("server.handshake.wait", serverHandshakeWait);
+                if (server != null)
+                {
+                    result
+                        .Metric("throughput.accepts", acceptRate)
+                        .Metric("throughput.accepts.peak", Storm.AcceptRatePeak)
+                        .Metric("handshakes.peak", serverStats.HandshakesPeak)
+                        .Metric("handshakes.shed", shed)
+                        .Metric("server.handshakes.resumed", serverResumed)
+                        .Metric("server.handshakes.full", serverFull)
+                        .Metric("memory.connection.managed", Storm.MemoryManaged)
+                        .Metric("memory.connection.private", Storm.MemoryPrivate);
+                }
+                if (swapped)
+                {
+                    result
+                        .Metric("swap.handshakes.resumed", resumedSwap)
+                        .Metric("swap.handshakes.full", fullSwap);
+                }
+                result.Write(Storm.Json);
+            }
+        }
+    }
+}
@@ -0,0 +1,210 @@
+﻿using System;
+using System.Threading;
+using CSharpServer;
+using CSharpServer.Benchmarks;
+using NDesk.Options;
+
+namespace TcpConnectStorm
+{
+    class StormSession : TcpSession
+    {
+        public StormSession(TcpServer server) : base(server) {}
+
+        protected override void OnError(int error, string category, string message)
+        {
+            Console.WriteLine($"Session caught an error with code {error} and category '{category}': {message}");
+        }
+    }
+
+    class StormServer : TcpServer
+    {
+        public StormServer(Service service, int port) : base(service, port) {}
+
+        protected override TcpSession CreateSession() { return new StormSession(this); }
+
+        protected override void OnError(int error, string category, string message)
+        {
+            Console.WriteLine($"Server caught an error with code {error} and category '{category}': {message}");
+        }
+    }
+
+    class StormClient : TcpClient, IStormClient
+    {
+        public StormClient(Service service, string address, int port) : base(service, address, port) {}
+
+        public bool Connect(long timestamp)
+        {
+            _timestamp = timestamp;
+            return ConnectAsync();
+        }
+
+        protected override void OnConnected()
+        {
+            Program.Storm.RecordConnect(_timestamp);
+            Program.Storm.Established(this);
+        }
+
+        protected override void OnDisconnected()
+        {
+            Program.Storm.Idle.Enqueue(this);
+        }
+
+        protected override void OnError(int error, string category, string message)
+        {
+            Interlocked.Increment(ref Program.Storm.TotalErrors);
+        }
+
+        private long _timestamp;
+    }
+
+    class Program
+    {
+        public static ConnectionStorm Storm = new ConnectionStorm(1111);
+
+        static void Main(string[] args)
+        {
+            bool help = false;
+
+            var options = new OptionSet()
+            {
+                { "h|?|help",   v => help = v != null }
+            };
+            Storm.AddOptions(options);
+
+            try
+            {
+                options.Parse(args);
+            }
+            catch (OptionException e)
+            {
+                Console.Write("Command line error: ");
+                Console.WriteLine(e.Message);
+                Console.WriteLine("Try `--help' to get usage information.");
+                return;
+            }
+
+            if (help)
+            {
+                Console.WriteLine("Usage:");
+                options.WriteOptionDescriptions(Console.Out);
+                Console.WriteLine();
+                Console.WriteLine("Opens and closes --rate connections per second using up to --clients");
+                Console.WriteLine("concurrent clients. Each connection is held for --hold milliseconds.");
+                Console.WriteLine("The server is hosted in-process unless --external is given, in that");
+                Console.WriteLine("case accept rate and memory per connection are not measured. Memory");
+                Console.WriteLine("per connection includes the client and the server side together.");
+                return;
+            }
+
+            // Capture process CPU time and GC collections from the very beginning
+            var result = (Storm.Json != null) ? new BenchmarkResult("TcpConnectStorm") : null;
+
+            Storm.Print();
+            Console.WriteLine($"Seconds to benchmarking: {Storm.Seconds}");
+            Console.WriteLine($"Seconds to warm-up: {Storm.Warmup}");
+
+            Console.WriteLine();
+
+            // Create a new service
+            var service = new Service(Storm.Threads);
+
+            // Start the service
+            Console.Write("Service starting...");
+            service.Start();
+            Console.WriteLine("Done!");
+
+            // Start the in-process server
+            StormServer server = null;
+            if (!Storm.External)
+            {
+                server = new StormServer(service, Storm.Port);
+                server.SetupReuseAddress(true);
+                Console.Write("Server starting...");
+                server.Start();
+                Console.WriteLine("Done!");
+            }
+
+            // Create storm clients
+            for (int i = 0; i < Storm.Clients; ++i)
+                Storm.Add(new StormClient(service, Storm.Address, Storm.Port));
+
+            // Measure memory per connection with all clients connected at once
+            var serverStats = new ServerStats();
+            if (server != null)
+            {
+                Console.Write("Measuring memory per connection...");
+                Storm.MeasureMemory(() => { server.GetStatistics(ref serverStats); return serverStats.ConnectedSessions; });
+                Console.WriteLine("Done!");
+                server.GetStatistics(ref serverStats);
+            }
+            long acceptedStart = serverStats.Accepted;
+
+            Console.Write("Benchmarking...");
+            Storm.Run((server != null) ? () => { server.GetStatistics(ref serverStats); return serverStats.AcceptRate; } : (Func<double>)null, null);
+            Console.WriteLine("Done!");
+
+            Storm.CloseAll();
+
+            if (server != null)
+            {
+                server.GetStatistics(ref serverStats);
+                Console.Write("Server stopping...");
+                server.Stop();
+                Console.WriteLine("Done!");
+            }
+
+            // Stop the service
+            Console.Write("Service stopping...");
+            service.Stop();
+            Console.WriteLine("Done!");
+
+            Console.WriteLine();
+
+            long connects = Storm.Connects;
+            long accepted = serverStats.Accepted - acceptedStart;
+            double acceptRate = accepted / (double)Storm.Seconds;
+            double cpuPerConnect = (connects > 0) ? (Storm.CpuTime.TotalMilliseconds * 1000000.0 / connects) : 0.0;
+
+            Console.WriteLine($"Errors: {Storm.TotalErrors}");
+
+            Console.WriteLine();
+
+            Console.WriteLine($"Total connects: {connects}");
+            Console.WriteLine($"Skipped connects (no idle client): {Storm.Skipped}");
+            Console.WriteLine($"Connect rate: {(long)(connects / (double)Storm.Seconds)} conn/s");
+            if (server != null)
+            {
+                Console.WriteLine($"Total accepted: {accepted}");
+                Console.WriteLine($"Accept rate: {(long)acceptRate} conn/s");
+                Console.WriteLine($"Accept rate peak: {(long)Storm.AcceptRatePeak} conn/s");
+                Console.WriteLine($"Memory per connection (client + server, managed): {Service.GenerateDataSize((long)Storm.MemoryManaged)}");
+                Console.WriteLine($"Memory per connection (client + server, private): {Service.GenerateDataSize((long)Storm.MemoryPrivate)}");
+            }
+            Console.WriteLine($"CPU per connection{(Storm.External ? "" : " (client + server)")}: {Service.GenerateTimePeriod(cpuPerConnect / 1000000.0)}");
+
+            Console.WriteLine();
+
+            ConnectionStorm.Report("Connect latency", Storm.ConnectLatency);
+
+            if (Storm.Json != null)
+            {
+                Storm.Describe(result);
+                result
+                    .Metric("errors", Storm.TotalErrors)
+                    .Metric("skipped", Storm.Skipped)
+                    .Metric("throughput.connects", connects / (double)Storm.Seconds)
+                    .Metric("cpu.connect", cpuPerConnect)
+                    .Latency("connect", Storm.ConnectLatency);
+                if (server != null)
+                {
+                    result
+                        .Metric("throughput.accepts", acceptRate)
+                        .Metric("throughput.accepts.peak", Storm.AcceptRatePeak)
+                        .Metric("memory.connection.managed", Storm.MemoryManaged)
+                        .Metric("memory.connection.private", Storm.MemoryPrivate);
+                }
+                result.Write(Storm.Json);
+            }
+        }
+    }
+}
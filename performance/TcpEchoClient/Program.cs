@@ -1,20 +1,28 @@
 ﻿using System;
 using System.Collections.Generic;
+using System.Diagnostics;
 using System.Threading;
 using CSharpServer;
+using CSharpServer.Benchmarks;
 using NDesk.Options;
 
 namespace TcpEchoClient
 {
-    class EchoClient : TcpClient
+    class EchoClient : TcpClient, IOpenLoopClient
     {
         public EchoClient(Service service, string address, int port, int messages) : base(service, address, port)
         {
             _messages = messages;
+            _message = (byte[])Program.MessageToSend.Clone();
+            _scheduled = (byte[])Program.MessageToSend.Clone();
+            _stamp = new byte[Math.Min(sizeof(long), _message.Length)];
         }
 
         protected override void OnConnected()
         {
+            if (Program.OpenLoop.Enabled)
+                return;
+
             for (long i = _messages; i > 0; --i)
                 SendMessage();
         }
@@ -26,11 +34,22 @@ namespace TcpEchoClient
 
         protected override void OnReceived(byte[] buffer, long size)
         {
-            _received += size;
-            while (_received >= Program.MessageToSend.Length)
+            // Reassemble echoed messages to find their send timestamps
+            for (long offset = 0; offset < size;)
             {
-                SendMessage();
-                _received -= Program.MessageToSend.Length;
+                long chunk = Math.Min(size - offset, _message.Length - _received);
+                if (_received < _stamp.Length)
+                    Array.Copy(buffer, offset, _stamp, _received, Math.Min(chunk, _stamp.Length - _received));
+                _received += chunk;
+                offset += chunk;
+
+                if (_received == _message.Length)
+                {
+                    Program.OpenLoop.RecordLatency(_stamp, 0);
+                    if (!Program.OpenLoop.Enabled)
+                        SendMessage();
+                    _received = 0;
+                }
             }
 
             Program.TimestampStop = DateTime.UtcNow;
@@ -45,12 +64,22 @@ namespace TcpEchoClient
 
         private void SendMessage()
         {
-            SendAsync(Program.MessageToSend);
+            OpenLoop.StampMessage(_message, Stopwatch.GetTimestamp());
+            SendAsync(_message);
+        }
+
+        public void SendScheduled(long timestamp)
+        {
+            OpenLoop.StampMessage(_scheduled, timestamp);
+            SendAsync(_scheduled);
         }
 
         private long _sent;
         private long _received;
         private long _messages;
+        private byte[] _message;
+        private byte[] _stamp;
+        private byte[] _scheduled;
     }
 
     class Program
@@ -61,6 +90,7 @@ namespace TcpEchoClient
         public static long TotalErrors;
         public static long TotalBytes;
         public static long TotalMessages;
+        public static OpenLoop OpenLoop = new OpenLoop();
 
         static void Main(string[] args)
         {
@@ -72,6 +102,8 @@ namespace TcpEchoClient
             int messages = 1000;
             int size = 32;
             int seconds = 10;
+            int warmup = 1;
+            string json = null;
 
             var options = new OptionSet()
             {
@@ -82,8 +114,11 @@ namespace TcpEchoClient
                 { "c|clients=", v => clients = int.Parse(v) },
                 { "m|messages=", v => messages = int.Parse(v) },
                 { "s|size=", v => size = int.Parse(v) },
-                { "z|seconds=", v => seconds = int.Parse(v) }
+                { "z|seconds=", v => seconds = int.Parse(v) },
+                { "w|warmup=", v => warmup = int.Parse(v) },
+                { "json=", v => json = v }
             };
+            OpenLoop.AddOptions(options);
 
             try
             {
@@ -104,6 +139,12 @@ namespace TcpEchoClient
                 return;
             }
 
+            // Capture process CPU time and GC collections from the very beginning
+            var result = (json != null) ? new BenchmarkResult("TcpEcho") : null;
+
+            // Prepare open-loop target rates
+            OpenLoop.Prepare();
+
             Console.WriteLine($"Server address: {address}");
             Console.WriteLine($"Server port: {port}");
             Console.WriteLine($"Working threads: {threads}");
@@ -111,6 +152,11 @@ namespace TcpEchoClient
             Console.WriteLine($"Working messages: {messages}");
             Console.WriteLine($"Message size: {size}");
             Console.WriteLine($"Seconds to benchmarking: {seconds}");
+            Console.WriteLine($"Seconds to warm-up: {warmup}");
+            if (OpenLoop.Enabled)
+                Console.WriteLine($"Open-loop rates: {string.Join(", ", OpenLoop.Rates)} msg/s");
+            if (size < sizeof(long))
+                Console.WriteLine($"Message size is less than {sizeof(long)} bytes, latency is not measured!");
 
             Console.WriteLine();
 
@@ -135,6 +181,7 @@ namespace TcpEchoClient
             }
 
             TimestampStart = DateTime.UtcNow;
+            OpenLoop.WarmupTimestamp = Stopwatch.GetTimestamp() + warmup * Stopwatch.Frequency;
 
             // Connect clients
             Console.Write("Clients connecting...");
@@ -146,10 +193,18 @@ namespace TcpEchoClient
                     Thread.Yield();
             Console.WriteLine("All clients connected!");
 
-            // Wait for benchmarking
-            Console.Write("Benchmarking...");
-            Thread.Sleep(seconds * 1000);
-            Console.WriteLine("Done!");
+            if (OpenLoop.Enabled)
+            {
+                OpenLoop.Run(echoClients, seconds, warmup);
+                Console.WriteLine();
+            }
+            else
+            {
+                // Wait for benchmarking
+                Console.Write("Benchmarking...");
+                Thread.Sleep(seconds * 1000);
+                Console.WriteLine("Done!");
+            }
 
             // Disconnect clients
             Console.Write("Clients disconnecting...");
@@ -180,9 +235,44 @@ namespace TcpEchoClient
             Console.WriteLine($"Data throughput: {Service.GenerateDataSize((long)(TotalBytes / (TimestampStop - TimestampStart).TotalSeconds))}/s");
             if (TotalMessages > 0)
             {
-                Console.WriteLine($"Message latency: {Service.GenerateTimePeriod((TimestampStop - TimestampStart).TotalMilliseconds / TotalMessages)}");
                 Console.WriteLine($"Message throughput: {(long)(TotalMessages / (TimestampStop - TimestampStart).TotalSeconds)} msg/s");
             }
+
+            Console.WriteLine();
+
+            Console.WriteLine($"Latency samples: {OpenLoop.Latency.TotalCount}");
+            if (OpenLoop.Latency.TotalCount > 0)
+            {
+                Console.WriteLine($"Latency min: {Service.GenerateTimePeriod(OpenLoop.Latency.Min / 1000000.0)}");
+                Console.WriteLine($"Latency mean: {Service.GenerateTimePeriod(OpenLoop.Latency.Mean / 1000000.0)}");
+                Console.WriteLine($"Latency p50: {Service.GenerateTimePeriod(OpenLoop.Latency.ValueAtPercentile(50) / 1000000.0)}");
+                Console.WriteLine($"Latency p90: {Service.GenerateTimePeriod(OpenLoop.Latency.ValueAtPercentile(90) / 1000000.0)}");
+                Console.WriteLine($"Latency p99: {Service.GenerateTimePeriod(OpenLoop.Latency.ValueAtPercentile(99) / 1000000.0)}");
+                Console.WriteLine($"Latency p99.9: {Service.GenerateTimePeriod(OpenLoop.Latency.ValueAtPercentile(99.9) / 1000000.0)}");
+                Console.WriteLine($"Latency max: {Service.GenerateTimePeriod(OpenLoop.Latency.Max / 1000000.0)}");
+            }
+
+            if (json != null)
+            {
+                result
+                    .Parameter("address", address)
+                    .Parameter("port", port)
+                    .Parameter("threads", threads)
+                    .Parameter("clients", clients)
+                    .Parameter("messages", messages)
+                    .Parameter("size", size)
+                    .Parameter("seconds", seconds)
+                    .Parameter("warmup", warmup)
+                    .Metric("errors", TotalErrors)
+                    .Metric("time", (TimestampStop - TimestampStart).TotalMilliseconds * 1000000.0)
+                    .Metric("bytes", TotalBytes)
+                    .Metric("messages", TotalMessages)
+                    .Metric("throughput.bytes", TotalBytes / (TimestampStop - TimestampStart).TotalSeconds)
+                    .Metric("throughput.messages", TotalMessages / (TimestampStop - TimestampStart).TotalSeconds)
+                    .Latency("latency", OpenLoop.Latency);
+                OpenLoop.Describe(result);
+                result.Write(json);
+            }
         }
     }
 }
@@ -2,6 +2,7 @@
 using System.Collections.Generic;
 using System.Threading;
 using CSharpServer;
+using CSharpServer.Benchmarks;
 using NDesk.Options;
 
 namespace TcpMulticastClient
@@ -42,6 +43,7 @@ namespace TcpMulticastClient
             int clients = 100;
             int size = 32;
             int seconds = 10;
+            string json = null;
 
             var options = new OptionSet()
             {
@@ -51,7 +53,8 @@ namespace TcpMulticastClient
                 { "t|threads=", v => threads = int.Parse(v) },
                 { "c|clients=", v => clients = int.Parse(v) },
                 { "s|size=", v => size = int.Parse(v) },
-                { "z|seconds=", v => seconds = int.Parse(v) }
+                { "z|seconds=", v => seconds = int.Parse(v) },
+                { "json=", v => json = v }
             };
 
             try
@@ -73,6 +76,9 @@ namespace TcpMulticastClient
                 return;
             }
 
+            // Capture process CPU time and GC collections from the very beginning
+            var result = (json != null) ? new BenchmarkResult("TcpMulticast") : null;
+
             Console.WriteLine($"Server address: {address}");
             Console.WriteLine($"Server port: {port}");
             Console.WriteLine($"Working threads: {threads}");
@@ -153,6 +159,24 @@ namespace TcpMulticastClient
                 Console.WriteLine($"Message latency: {Service.GenerateTimePeriod((TimestampStop - TimestampStart).TotalMilliseconds / TotalMessages)}");
                 Console.WriteLine($"Message throughput: {(long)(TotalMessages / (TimestampStop - TimestampStart).TotalSeconds)} msg/s");
             }
+
+            if (json != null)
+            {
+                result
+                    .Parameter("address", address)
+                    .Parameter("port", port)
+                    .Parameter("threads", threads)
+                    .Parameter("clients", clients)
+                    .Parameter("size", size)
+                    .Parameter("seconds", seconds)
+                    .Metric("errors", TotalErrors)
+                    .Metric("time", (TimestampStop - TimestampStart).TotalMilliseconds * 1000000.0)
+                    .Metric("bytes", TotalBytes)
+                    .Metric("messages", TotalMessages)
+                    .Metric("throughput.bytes", TotalBytes / (TimestampStop - TimestampStart).TotalSeconds)
+                    .Metric("throughput.messages", TotalMessages / (TimestampStop - TimestampStart).TotalSeconds)
+                    .Write(json);
+            }
         }
     }
 }
@@ -0,0 +1,235 @@
+﻿using System;
+using System.IO;
+using System.Threading;
+using CSharpServer;
+using NDesk.Options;
+
+namespace TcpProxyServer
+{
+    class ProxyRelay : TcpRelay
+    {
+        public ProxyRelay(TcpSession session, TcpClient client) : base(session, client) {}
+
+        protected override void OnClosed(bool client)
+        {
+            Interlocked.Add(ref Program.BytesUpstream, BytesUpstream);
+            Interlocked.Add(ref Program.BytesDownstream, BytesDownstream);
+            Interlocked.Add(ref Program.Overflows, Overflows);
+            Interlocked.Increment(ref Program.Relays);
+        }
+    }
+
+    class ProxyClient : TcpClient
+    {
+        public ProxyClient(Service service, string address, int port, ProxySession session) : base(service, address, port)
+        {
+            _session = session;
+        }
+
+        protected override void OnConnected()
+        {
+            _session.Flush();
+        }
+
+        protected override void OnDisconnected()
+        {
+            // Native relay disconnects the session by itself
+            if (Program.Managed)
+                _session.Disconnect();
+        }
+
+        protected override void OnReceived(byte[] buffer, long size)
+        {
+            // Reached only by the managed forwarding
+            Interlocked.Add(ref Program.BytesDownstream, size);
+            _session.SendAsync(buffer, 0, size);
+        }
+
+        protected override void OnError(int error, string category, string message)
+        {
+            Console.WriteLine($"Upstream client caught an error with code {error} and category '{category}': {message}");
+        }
+
+        private readonly ProxySession _session;
+    }
+
+    class ProxySession : TcpSession
+    {
+        public ProxySession(TcpServer server) : base(server) {}
+
+        protected override void OnConnected()
+        {
+            _client = new ProxyClient(Server.Service, Program.Address, Program.UpstreamPort, this);
+
+            if (!Program.Managed)
+            {
+                // Data received before the upstream is connected is buffered by the relay
+                var relay = new ProxyRelay(this, _client);
+                relay.SetupPendingLimit(Program.Limit);
+                relay.Start();
+            }
+
+            _client.ConnectAsync();
+        }
+
+        protected override void OnDisconnected()
+        {
+            if (Program.Managed)
+            {
+                _client.DisconnectAsync();
+                Interlocked.Increment(ref Program.Relays);
+            }
+        }
+
+        protected override void OnReceived(byte[] buffer, long size)
+        {
+            // Reached only by the managed forwarding
+            Interlocked.Add(ref Program.BytesUpstream, size);
+            lock (_pending)
+            {
+                if (!_flushed)
+                {
+                    _pending.Write(buffer, 0, (int)size);
+                    return;
+                }
+            }
+            _client.SendAsync(buffer, 0, size);
+        }
+
+        protected override void OnError(int error, string category, string message)
+        {
+            Console.WriteLine($"Session caught an error with code {error} and category '{category}': {message}");
+        }
+
+        // Flush data received before the upstream was connected (managed forwarding only)
+        public void Flush()
+        {
+            lock (_pending)
+            {
+                if (_pending.Length > 0)
+                    _client.SendAsync(_pending.GetBuffer(), 0, _pending.Length);
+                _pending.SetLength(0);
+                _flushed = true;
+            }
+        }
+
+        private ProxyClient _client;
+        private bool _flushed;
+        private readonly MemoryStream _pending = new MemoryStream();
+    }
+
+    class ProxyServer : TcpServer
+    {
+        public ProxyServer(Service service, int port, InternetProtocol protocol) : base(service, port, protocol) {}
+
+        protected override TcpSession CreateSession() { return new ProxySession(this); }
+
+        protected override void OnError(int error, string category, string message)
+        {
+            Console.WriteLine($"Server caught an error with code {error} and category '{category}': {message}");
+        }
+    }
+
+    class Program
+    {
+        public static string Address = "127.0.0.1";
+        public static int UpstreamPort = 1111;
+        public static bool Managed;
+        public static long Limit = 4 * 1024 * 1024;
+
+        public static long Relays;
+        public static long BytesUpstream;
+        public static long BytesDownstream;
+        public static long Overflows;
+
+        static void Main(string[] args)
+        {
+            bool help = false;
+            int port = 1112;
+            int threads = Environment.ProcessorCount;
+
+            var options = new OptionSet()
+            {
+                { "h|?|help",   v => help = v != null },
+                { "p|port=", v => port = int.Parse(v) },
+                { "a|address=", v => Address = v },
+                { "u|upstream=", v => UpstreamPort = int.Parse(v) },
+                { "t|threads=", v => threads = int.Parse(v) },
+                { "l|limit=", v => Limit = long.Parse(v) },
+                { "m|managed", v => Managed = v != null }
+            };
+
+            try
+            {
+                options.Parse(args);
+            }
+            catch (OptionException e)
+            {
+                Console.Write("Command line error: ");
+                Console.WriteLine(e.Message);
+                Console.WriteLine("Try `--help' to get usage information.");
+                return;
+            }
+
+            if (help)
+            {
+                Console.WriteLine("Usage:");
+                options.WriteOptionDescriptions(Console.Out);
+                Console.WriteLine();
+                Console.WriteLine("Proxies connections to the upstream echo server. Run TcpEchoServer on the");
+                Console.WriteLine("upstream port and TcpEchoClient against the proxy port, then compare the");
+                Console.WriteLine("native relay with the managed forwarding (--managed). Lower the pending");
+                Console.WriteLine("limit (--limit) below the in-flight data to observe relay overflows.");
+                return;
+            }
+
+            Console.WriteLine($"Server port: {port}");
+            Console.WriteLine($"Upstream: {Address}:{UpstreamPort}");
+            Console.WriteLine($"Working threads: {threads}");
+            Console.WriteLine($"Forwarding: {(Managed ? "managed" : "native relay")}");
+            if (!Managed)
+                Console.WriteLine($"Pending limit: {Limit}");
+
+            Console.WriteLine();
+
+            // Create a new service
+            var service = new Service(threads);
+
+            // Start the service
+            Console.Write("Service starting...");
+            service.Start();
+            Console.WriteLine("Done!");
+
+            // Create a new proxy server
+            var server = new ProxyServer(service, port, InternetProtocol.IPv4);
+            server.SetupReuseAddress(true);
+            server.SetupReusePort(true);
+
+            // Start the server
+            Console.Write("Server starting...");
+            server.Start();
+            Console.WriteLine("Done!");
+
+            Console.WriteLine("Press Enter to stop the server...");
+            Console.ReadLine();
+
+            // Stop the server
+            Console.Write("Server stopping...");
+            server.Stop();
+            Console.WriteLine("Done!");
+
+            // Stop the service
+            Console.Write("Service stopping...");
+            service.Stop();
+            Console.WriteLine("Done!");
+
+            Console.WriteLine();
+
+            Console.WriteLine($"Closed connections: {Relays}");
+            Console.WriteLine($"Bytes upstream: {BytesUpstream}");
+            Console.WriteLine($"Bytes downstream: {BytesDownstream}");
+            if (!Managed)
+                Console.WriteLine($"Pending limit overflows: {Overflows}");
+        }
+    }
+}
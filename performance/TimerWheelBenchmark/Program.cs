@@ -0,0 +1,163 @@
+﻿using System;
+using System.Threading;
+using CSharpServer;
+using CSharpServer.Benchmarks;
+using NDesk.Options;
+
+namespace TimerWheelBenchmark
+{
+    class BenchmarkTimerWheel : TimerWheel
+    {
+        public BenchmarkTimerWheel(Service service, TimeSpan tick) : base(service, tick) {}
+
+        protected override void OnExpired(long[] timers)
+        {
+            Interlocked.Add(ref Program.TotalExpired, timers.Length);
+            Interlocked.Increment(ref Program.TotalBatches);
+        }
+    }
+
+    class Program
+    {
+        public static long TotalExpired;
+        public static long TotalBatches;
+
+        static void Main(string[] args)
+        {
+            bool help = false;
+            int threads = Environment.ProcessorCount;
+            int timers = 1000000;
+            int tick = 1;
+            int timeout = 1000;
+            string json = null;
+
+            var options = new OptionSet()
+            {
+                { "h|?|help",   v => help = v != null },
+                { "t|threads=", v => threads = int.Parse(v) },
+                { "n|timers=", v => timers = int.Parse(v) },
+                { "k|tick=", v => tick = int.Parse(v) },
+                { "o|timeout=", v => timeout = int.Parse(v) },
+                { "json=", v => json = v }
+            };
+
+            try
+            {
+                options.Parse(args);
+            }
+            catch (OptionException e)
+            {
+                Console.Write("Command line error: ");
+                Console.WriteLine(e.Message);
+                Console.WriteLine("Try `--help' to get usage information.");
+                return;
+            }
+
+            if (help)
+            {
+                Console.WriteLine("Usage:");
+                options.WriteOptionDescriptions(Console.Out);
+                return;
+            }
+
+            // Capture process CPU time and GC collections from the very beginning
+            var result = (json != null) ? new BenchmarkResult("TimerWheel") : null;
+
+            Console.WriteLine($"Working threads: {threads}");
+            Console.WriteLine($"Timers count: {timers}");
+            Console.WriteLine($"Timer wheel tick: {tick} ms");
+            Console.WriteLine($"Timer timeout: {timeout} ms");
+
+            Console.WriteLine();
+
+            // Create a new service
+            var service = new Service(threads);
+
+            // Start the service
+            Console.Write("Service starting...");
+            service.Start();
+            Console.WriteLine("Done!");
+
+            // Create and start a new timer wheel
+            var wheel = new BenchmarkTimerWheel(service, TimeSpan.FromMilliseconds(tick));
+            wheel.Start();
+
+            var handles = new long[timers];
+
+            // Schedule timers
+            Console.Write("Scheduling timers...");
+            var timestampStart = DateTime.UtcNow;
+            for (int i = 0; i < timers; ++i)
+                handles[i] = wheel.Schedule(TimeSpan.FromMilliseconds(timeout + (i % timeout)));
+            var scheduleTime = DateTime.UtcNow - timestampStart;
+            Console.WriteLine("Done!");
+
+            // Reschedule timers
+            Console.Write("Rescheduling timers...");
+            timestampStart = DateTime.UtcNow;
+            for (int i = 0; i < timers; ++i)
+                wheel.Reschedule(handles[i], TimeSpan.FromMilliseconds(timeout + ((i * 7) % timeout)));
+            var rescheduleTime = DateTime.UtcNow - timestampStart;
+            Console.WriteLine("Done!");
+
+            // Cancel timers
+            Console.Write("Canceling timers...");
+            timestampStart = DateTime.UtcNow;
+            for (int i = 0; i < timers; ++i)
+                wheel.Cancel(handles[i]);
+            var cancelTime = DateTime.UtcNow - timestampStart;
+            Console.WriteLine("Done!");
+
+            // Schedule timers once again and wait for all of them to expire
+            Console.Write("Expiring timers...");
+            for (int i = 0; i < timers; ++i)
+                wheel.Schedule(TimeSpan.FromMilliseconds(i % timeout));
+            timestampStart = DateTime.UtcNow;
+            while (Interlocked.Read(ref TotalExpired) < timers)
+                Thread.Sleep(1);
+            var expireTime = DateTime.UtcNow - timestampStart;
+            Console.WriteLine("Done!");
+
+            // Stop the timer wheel
+            wheel.Stop();
+
+            // Stop the service
+            Console.Write("Service stopping...");
+            service.Stop();
+            Console.WriteLine("Done!");
+
+            Console.WriteLine();
+
+            Console.WriteLine($"Schedule time: {Service.GenerateTimePeriod(scheduleTime.TotalMilliseconds)}");
+            Console.WriteLine($"Schedule latency: {Service.GenerateTimePeriod(scheduleTime.TotalMilliseconds / timers)}");
+            Console.WriteLine($"Schedule throughput: {(long)(timers / scheduleTime.TotalSeconds)} ops/s");
+            Console.WriteLine($"Reschedule time: {Service.GenerateTimePeriod(rescheduleTime.TotalMilliseconds)}");
+            Console.WriteLine($"Reschedule latency: {Service.GenerateTimePeriod(rescheduleTime.TotalMilliseconds / timers)}");
+            Console.WriteLine($"Reschedule throughput: {(long)(timers / rescheduleTime.TotalSeconds)} ops/s");
+            Console.WriteLine($"Cancel time: {Service.GenerateTimePeriod(cancelTime.TotalMilliseconds)}");
+            Console.WriteLine($"Cancel latency: {Service.GenerateTimePeriod(cancelTime.TotalMilliseconds / timers)}");
+            Console.WriteLine($"Cancel throughput: {(long)(timers / cancelTime.TotalSeconds)} ops/s");
+            Console.WriteLine($"Expire time: {Service.GenerateTimePeriod(expireTime.TotalMilliseconds)}");
+            Console.WriteLine($"Expired timers: {TotalExpired}");
+            Console.WriteLine($"Expired batches: {TotalBatches}");
+
+            if (json != null)
+            {
+                result
+                    .Parameter("threads", threads)
+                    .Parameter("timers", timers)
+                    .Parameter("tick", tick)
+                    .Parameter("timeout", timeout)
+                    .Metric("schedule.latency", scheduleTime.TotalMilliseconds * 1000000.0 / timers)
+                    .Metric("schedule.throughput", timers / scheduleTime.TotalSeconds)
+                    .Metric("reschedule.latency", rescheduleTime.TotalMilliseconds * 1000000.0 / timers)
+                    .Metric("reschedule.throughput", timers / rescheduleTime.TotalSeconds)
+                    .Metric("cancel.latency", cancelTime.TotalMilliseconds * 1000000.0 / timers)
+                    .Metric("cancel.throughput", timers / cancelTime.TotalSeconds)
+                    .Metric("expire.time", expireTime.TotalMilliseconds * 1000000.0)
+                    .Metric("expire.batches", TotalBatches)
+                    .Write(json);
+            }
+        }
+    }
+}
@@ -1,16 +1,21 @@
 ﻿using System;
 using System.Collections.Generic;
+using System.Diagnostics;
+using System.Linq;
 using System.Threading;
 using CSharpServer;
+using CSharpServer.Benchmarks;
 using NDesk.Options;
 
 namespace UdpEchoClient
 {
-    class EchoClient : UdpClient
+    class EchoClient : UdpClient, IOpenLoopClient
     {
         public EchoClient(Service service, string address, int port, int messages) : base(service, address, port)
         {
             _messages = messages;
+            _message = (byte[])Program.MessageToSend.Clone();
+            _scheduled = (byte[])Program.MessageToSend.Clone();
         }
 
         protected override void OnConnected()
@@ -18,12 +23,21 @@ namespace UdpEchoClient
             // Start receive datagrams
             ReceiveAsync();
 
+            if (Program.OpenLoop.Enabled)
+                return;
+
             for (long i = _messages; i > 0; --i)
                 SendMessage();
         }
 
         protected override void OnReceived(UdpEndpoint endpoint, byte[] buffer, long size)
         {
+            if (size == Program.MessageToSend.Length)
+            {
+                Program.OpenLoop.RecordLatency(buffer, 0);
+                Tracker.Track(buffer, size);
+            }
+
             Program.TimestampStop = DateTime.UtcNow;
             Program.TotalBytes += size;
             ++Program.TotalMessages;
@@ -31,7 +45,8 @@ namespace UdpEchoClient
             // Continue receive datagrams
             ReceiveAsync();
 
-            SendMessage();
+            if (!Program.OpenLoop.Enabled)
+                SendMessage();
         }
 
         protected override void OnError(int error, string category, string message)
@@ -42,10 +57,40 @@ namespace UdpEchoClient
 
         private void SendMessage()
         {
-            SendAsync(Program.MessageToSend);
+            Send(_message, Stopwatch.GetTimestamp());
+        }
+
+        public void SendScheduled(long timestamp)
+        {
+            Send(_scheduled, timestamp);
         }
 
+        // Embed the send timestamp and the sequence number into the datagram
+        private void Send(byte[] message, long timestamp)
+        {
+            if (message.Length < SequenceTracker.HeaderSize)
+            {
+                OpenLoop.StampMessage(message, timestamp);
+                SendAsync(message);
+                return;
+            }
+
+            // Rejected datagram does not consume the sequence number, so it is not counted as lost
+            lock (_lock)
+            {
+                SequenceTracker.Stamp(message, timestamp, _sequence + 1);
+                if (SendAsync(message))
+                    ++_sequence;
+            }
+        }
+
+        public SequenceTracker Tracker = new SequenceTracker();
+
+        private object _lock = new object();
+        private long _sequence;
         private long _messages;
+        private byte[] _message;
+        private byte[] _scheduled;
     }
 
     class Program
@@ -56,6 +101,87 @@ namespace UdpEchoClient
         public static long TotalErrors;
         public static long TotalBytes;
         public static long TotalMessages;
+        public static LossOpenLoop OpenLoop = new LossOpenLoop();
+
+        // Datagram loss statistics aggregated over all clients
+        class LossReport
+        {
+            public long Expected;
+            public long Lost;
+            public long Duplicates;
+            public long Reordered;
+            public long SystemErrors;
+            public LatencyHistogram Jitter = new LatencyHistogram();
+
+            public double LossRate => (Expected > 0) ? (double)Lost / Expected : 0.0;
+
+            public static LossReport Collect(IEnumerable<EchoClient> clients, long systemErrors)
+            {
+                var report = new LossReport { SystemErrors = SequenceTracker.SystemReceiveErrors() - systemErrors };
+                foreach (var client in clients)
+                {
+                    report.Expected += client.Tracker.Highest - client.Tracker.First + 1;
+                    report.Lost += client.Tracker.Lost;
+                    report.Duplicates += client.Tracker.Duplicates;
+                    report.Reordered += client.Tracker.Reordered;
+                    report.Jitter.Merge(client.Tracker.Variation);
+                }
+                return report;
+            }
+
+            public void Print()
+            {
+                Console.WriteLine($"Datagrams expected: {Expected}");
+                Console.WriteLine($"Datagrams lost: {Lost} ({LossRate * 100.0:F3}%)");
+                Console.WriteLine($"Datagrams reordered: {Reordered}");
+                Console.WriteLine($"Datagrams duplicated: {Duplicates}");
+                Console.WriteLine($"System UDP receive errors: {SystemErrors}");
+                if (Jitter.TotalCount > 0)
+                {
+                    Console.WriteLine($"Round-trip jitter p50: {Service.GenerateTimePeriod(Jitter.ValueAtPercentile(50) / 1000000.0)}");
+                    Console.WriteLine($"Round-trip jitter p90: {Service.GenerateTimePeriod(Jitter.ValueAtPercentile(90) / 1000000.0)}");
+                    Console.WriteLine($"Round-trip jitter p99: {Service.GenerateTimePeriod(Jitter.ValueAtPercentile(99) / 1000000.0)}");
+                    Console.WriteLine($"Round-trip jitter p99.9: {Service.GenerateTimePeriod(Jitter.ValueAtPercentile(99.9) / 1000000.0)}");
+                    Console.WriteLine($"Round-trip jitter max: {Service.GenerateTimePeriod(Jitter.Max / 1000000.0)}");
+                }
+            }
+
+            public void AddMetrics(string prefix)
+            {
+                OpenLoop.Metrics.Add(new KeyValuePair<string, double>(prefix + "loss", LossRate));
+                OpenLoop.Metrics.Add(new KeyValuePair<string, double>(prefix + "reordered", Reordered));
+                OpenLoop.Metrics.Add(new KeyValuePair<string, double>(prefix + "duplicates", Duplicates));
+                OpenLoop.Metrics.Add(new KeyValuePair<string, double>(prefix + "drops.system", SystemErrors));
+                if (Jitter.TotalCount > 0)
+                {
+                    OpenLoop.Metrics.Add(new KeyValuePair<string, double>(prefix + "jitter.p50", Jitter.ValueAtPercentile(50)));
+                    OpenLoop.Metrics.Add(new KeyValuePair<string, double>(prefix + "jitter.p99", Jitter.ValueAtPercentile(99)));
+                    OpenLoop.Metrics.Add(new KeyValuePair<string, double>(prefix + "jitter.p99.9", Jitter.ValueAtPercentile(99.9)));
+                }
+            }
+        }
+
+        // Open-loop mode with datagram loss statistics of each target rate
+        public class LossOpenLoop : OpenLoop
+        {
+            protected override string Columns => " | Loss | Reordered | Duplicates | System drops | Jitter p99";
+
+            protected override void OnRateStarting(IReadOnlyList<IOpenLoopClient> clients, long rate)
+            {
+                foreach (var client in clients.Cast<EchoClient>())
+                    client.Tracker.Reset();
+                _systemErrors = SequenceTracker.SystemReceiveErrors();
+            }
+
+            protected override string OnRateFinished(IReadOnlyList<IOpenLoopClient> clients, long rate)
+            {
+                var loss = LossReport.Collect(clients.Cast<EchoClient>(), _systemErrors);
+                loss.AddMetrics($"openloop.{rate}.");
+                return $" | {loss.LossRate * 100.0:F3}% | {loss.Reordered} | {loss.Duplicates} | {loss.SystemErrors} | {Service.GenerateTimePeriod(loss.Jitter.ValueAtPercentile(99) / 1000000.0)}";
+            }
+
+            private long _systemErrors;
+        }
 
         static void Main(string[] args)
         {
@@ -67,6 +193,9 @@ namespace UdpEchoClient
             int messages = 1000;
             int size = 32;
             int seconds = 10;
+            int warmup = 1;
+            int rcvbuf = 0;
+            string json = null;
 
             var options = new OptionSet()
             {
@@ -77,8 +206,12 @@ namespace UdpEchoClient
                 { "c|clients=", v => clients = int.Parse(v) },
                 { "m|messages=", v => messages = int.Parse(v) },
                 { "s|size=", v => size = int.Parse(v) },
-                { "z|seconds=", v => seconds = int.Parse(v) }
+                { "z|seconds=", v => seconds = int.Parse(v) },
+                { "w|warmup=", v => warmup = int.Parse(v) },
+                { "rcvbuf=", v => rcvbuf = int.Parse(v) },
+                { "json=", v => json = v }
             };
+            OpenLoop.AddOptions(options);
 
             try
             {
@@ -96,9 +229,19 @@ namespace UdpEchoClient
             {
                 Console.WriteLine("Usage:");
                 options.WriteOptionDescriptions(Console.Out);
+                Console.WriteLine();
+                Console.WriteLine("Datagrams of at least 16 bytes carry a sequence number to measure loss,");
+                Console.WriteLine("reordering, duplicates and jitter. --rcvbuf sets the client socket");
+                Console.WriteLine("receive buffer size in bytes.");
                 return;
             }
 
+            // Capture process CPU time and GC collections from the very beginning
+            var result = (json != null) ? new BenchmarkResult("UdpEcho") : null;
+
+            // Prepare open-loop target rates
+            OpenLoop.Prepare();
+
             Console.WriteLine($"Server address: {address}");
             Console.WriteLine($"Server port: {port}");
             Console.WriteLine($"Working threads: {threads}");
@@ -106,6 +249,15 @@ namespace UdpEchoClient
             Console.WriteLine($"Working messages: {messages}");
             Console.WriteLine($"Message size: {size}");
             Console.WriteLine($"Seconds to benchmarking: {seconds}");
+            Console.WriteLine($"Seconds to warm-up: {warmup}");
+            if (OpenLoop.Enabled)
+                Console.WriteLine($"Open-loop rates: {string.Join(", ", OpenLoop.Rates)} msg/s");
+            if (rcvbuf > 0)
+                Console.WriteLine($"Receive buffer size: {rcvbuf}");
+            if (size < sizeof(long))
+                Console.WriteLine($"Message size is less than {sizeof(long)} bytes, latency is not measured!");
+            if (size < SequenceTracker.HeaderSize)
+                Console.WriteLine($"Message size is less than {SequenceTracker.HeaderSize} bytes, loss is not measured!");
 
             Console.WriteLine();
 
@@ -125,10 +277,14 @@ namespace UdpEchoClient
             for (int i = 0; i < clients; ++i)
             {
                 var client = new EchoClient(service, address, port, messages);
+                if (rcvbuf > 0)
+                    client.SetupReceiveBufferSize(rcvbuf);
                 echoClients.Add(client);
             }
 
+            long systemErrors = SequenceTracker.SystemReceiveErrors();
             TimestampStart = DateTime.UtcNow;
+            OpenLoop.WarmupTimestamp = Stopwatch.GetTimestamp() + warmup * Stopwatch.Frequency;
 
             // Connect clients
             Console.Write("Clients connecting...");
@@ -140,10 +296,20 @@ namespace UdpEchoClient
                     Thread.Yield();
             Console.WriteLine("All clients connected!");
 
-            // Wait for benchmarking
-            Console.Write("Benchmarking...");
-            Thread.Sleep(seconds * 1000);
-            Console.WriteLine("Done!");
+            if (OpenLoop.Enabled)
+            {
+                OpenLoop.Run(echoClients, seconds, warmup);
+                Console.WriteLine();
+            }
+            else
+            {
+                // Wait for benchmarking
+                Console.Write("Benchmarking...");
+                Thread.Sleep(seconds * 1000);
+                Console.WriteLine("Done!");
+            }
+
+            var loss = LossReport.Collect(echoClients, systemErrors);
 
             // Disconnect clients
             Console.Write("Clients disconnecting...");
@@ -172,9 +338,53 @@ namespace UdpEchoClient
             Console.WriteLine($"Data throughput: {Service.GenerateDataSize((long)(TotalBytes / (TimestampStop - TimestampStart).TotalSeconds))}/s");
             if (TotalMessages > 0)
             {
-                Console.WriteLine($"Message latency: {Service.GenerateTimePeriod((TimestampStop - TimestampStart).TotalMilliseconds / TotalMessages)}");
                 Console.WriteLine($"Message throughput: {(long)(TotalMessages / (TimestampStop - TimestampStart).TotalSeconds)} msg/s");
             }
+
+            Console.WriteLine();
+
+            Console.WriteLine($"Latency samples: {OpenLoop.Latency.TotalCount}");
+            if (OpenLoop.Latency.TotalCount > 0)
+            {
+                Console.WriteLine($"Latency min: {Service.GenerateTimePeriod(OpenLoop.Latency.Min / 1000000.0)}");
+                Console.WriteLine($"Latency mean: {Service.GenerateTimePeriod(OpenLoop.Latency.Mean / 1000000.0)}");
+                Console.WriteLine($"Latency p50: {Service.GenerateTimePeriod(OpenLoop.Latency.ValueAtPercentile(50) / 1000000.0)}");
+                Console.WriteLine($"Latency p90: {Service.GenerateTimePeriod(OpenLoop.Latency.ValueAtPercentile(90) / 1000000.0)}");
+                Console.WriteLine($"Latency p99: {Service.GenerateTimePeriod(OpenLoop.Latency.ValueAtPercentile(99) / 1000000.0)}");
+                Console.WriteLine($"Latency p99.9: {Service.GenerateTimePeriod(OpenLoop.Latency.ValueAtPercentile(99.9) / 1000000.0)}");
+                Console.WriteLine($"Latency max: {Service.GenerateTimePeriod(OpenLoop.Latency.Max / 1000000.0)}");
+            }
+
+            if (!OpenLoop.Enabled && (size >= SequenceTracker.HeaderSize))
+            {
+                Console.WriteLine();
+
+                loss.Print();
+                loss.AddMetrics("");
+            }
+
+            if (json != null)
+            {
+                result
+                    .Parameter("address", address)
+                    .Parameter("port", port)
+                    .Parameter("threads", threads)
+                    .Parameter("clients", clients)
+                    .Parameter("messages", messages)
+                    .Parameter("size", size)
+                    .Parameter("seconds", seconds)
+                    .Parameter("warmup", warmup)
+                    .Parameter("rcvbuf", rcvbuf)
+                    .Metric("errors", TotalErrors)
+                    .Metric("time", (TimestampStop - TimestampStart).TotalMilliseconds * 1000000.0)
+                    .Metric("bytes", TotalBytes)
+                    .Metric("messages", TotalMessages)
+                    .Metric("throughput.bytes", TotalBytes / (TimestampStop - TimestampStart).TotalSeconds)
+                    .Metric("throughput.messages", TotalMessages / (TimestampStop - TimestampStart).TotalSeconds)
+                    .Latency("latency", OpenLoop.Latency);
+                OpenLoop.Describe(result);
+                result.Write(json);
+            }
         }
     }
 }
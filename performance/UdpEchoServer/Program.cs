@@ -46,12 +46,14 @@ namespace UdpEchoServer
             bool help = false;
             int port = 3333;
             int threads = Environment.ProcessorCount;
+            int rcvbuf = 0;
 
             var options = new OptionSet()
             {
                 { "h|?|help",   v => help = v != null },
                 { "p|port=", v => port = int.Parse(v) },
-                { "t|threads=", v => threads = int.Parse(v) }
+                { "t|threads=", v => threads = int.Parse(v) },
+                { "rcvbuf=", v => rcvbuf = int.Parse(v) }
             };
 
             try
@@ -75,6 +77,8 @@ namespace UdpEchoServer
 
             Console.WriteLine($"Server port: {port}");
             Console.WriteLine($"Working threads: {threads}");
+            if (rcvbuf > 0)
+                Console.WriteLine($"Receive buffer size: {rcvbuf}");
 
             Console.WriteLine();
 
@@ -90,6 +94,8 @@ namespace UdpEchoServer
             var server = new EchoServer(service, port, InternetProtocol.IPv4);
             server.SetupReuseAddress(true);
             server.SetupReusePort(true);
+            if (rcvbuf > 0)
+                server.SetupReceiveBufferSize(rcvbuf);
 
             // Start the server
             Console.Write("Server starting...");
@@ -2,6 +2,7 @@
 using System.Collections.Generic;
 using System.Threading;
 using CSharpServer;
+using CSharpServer.Benchmarks;
 using NDesk.Options;
 
 namespace UdpMulticastClient
@@ -27,6 +28,8 @@ namespace UdpMulticastClient
         protected override void OnReceived(UdpEndpoint endpoint, byte[] buffer, long size)
         {
             Program.TotalBytes += size;
+            if (size == Program.MessageToSend.Length)
+                Tracker.Track(buffer, size);
 
             // Continue receive datagrams
             ReceiveAsync();
@@ -37,6 +40,8 @@ namespace UdpMulticastClient
             Console.WriteLine($"Client caught an error with code {error} and category '{category}': {message}");
             ++Program.TotalErrors;
         }
+
+        public SequenceTracker Tracker = new SequenceTracker();
     }
 
     class Program
@@ -57,6 +62,8 @@ namespace UdpMulticastClient
             int clients = 100;
             int size = 32;
             int seconds = 10;
+            int rcvbuf = 0;
+            string json = null;
 
             var options = new OptionSet()
             {
@@ -66,7 +73,9 @@ namespace UdpMulticastClient
                 { "t|threads=", v => threads = int.Parse(v) },
                 { "c|clients=", v => clients = int.Parse(v) },
                 { "s|size=", v => size = int.Parse(v) },
-                { "z|seconds=", v => seconds = int.Parse(v) }
+                { "z|seconds=", v => seconds = int.Parse(v) },
+                { "rcvbuf=", v => rcvbuf = int.Parse(v) },
+                { "json=", v => json = v }
             };
 
             try
@@ -88,11 +97,16 @@ namespace UdpMulticastClient
                 return;
             }
 
+            // Capture process CPU time and GC collections from the very beginning
+            var result = (json != null) ? new BenchmarkResult("UdpMulticast") : null;
+
             Console.WriteLine($"Server address: {address}");
             Console.WriteLine($"Server port: {port}");
             Console.WriteLine($"Working threads: {threads}");
             Console.WriteLine($"Working clients: {clients}");
             Console.WriteLine($"Message size: {size}");
+            if (rcvbuf > 0)
+                Console.WriteLine($"Receive buffer size: {rcvbuf}");
             Console.WriteLine($"Seconds to benchmarking: {seconds}");
 
             Console.WriteLine();
@@ -114,9 +128,12 @@ namespace UdpMulticastClient
             {
                 var client = new MulticastClient(service, "0.0.0.0", address, port);
                 client.SetupMulticast(true);
+                if (rcvbuf > 0)
+                    client.SetupReceiveBufferSize(rcvbuf);
                 multicastClients.Add(client);
             }
 
+            long systemErrors = SequenceTracker.SystemReceiveErrors();
             TimestampStart = DateTime.UtcNow;
 
             // Connect clients
@@ -134,6 +151,20 @@ namespace UdpMulticastClient
             Thread.Sleep(seconds * 1000);
             Console.WriteLine("Done!");
 
+            // Collect datagram loss statistics
+            systemErrors = SequenceTracker.SystemReceiveErrors() - systemErrors;
+            long expected = 0, lost = 0, duplicates = 0, reordered = 0;
+            var jitter = new LatencyHistogram();
+            foreach (var client in multicastClients)
+            {
+                expected += client.Tracker.Highest - client.Tracker.First + 1;
+                lost += client.Tracker.Lost;
+                duplicates += client.Tracker.Duplicates;
+                reordered += client.Tracker.Reordered;
+                jitter.Merge(client.Tracker.Variation);
+            }
+            double loss = (expected > 0) ? (double)lost / expected : 0.0;
+
             // Disconnect clients
             Console.Write("Clients disconnecting...");
             foreach (var client in multicastClients)
@@ -168,6 +199,49 @@ namespace UdpMulticastClient
                 Console.WriteLine($"Message latency: {Service.GenerateTimePeriod((TimestampStop - TimestampStart).TotalMilliseconds / TotalMessages)}");
                 Console.WriteLine($"Message throughput: {(long)(TotalMessages / (TimestampStop - TimestampStart).TotalSeconds)} msg/s");
             }
+
+            if (size >= SequenceTracker.HeaderSize)
+            {
+                Console.WriteLine();
+
+                Console.WriteLine($"Datagrams expected: {expected}");
+                Console.WriteLine($"Datagrams lost: {lost} ({loss * 100.0:F3}%)");
+                Console.WriteLine($"Datagrams reordered: {reordered}");
+                Console.WriteLine($"Datagrams duplicated: {duplicates}");
+                Console.WriteLine($"System UDP receive errors: {systemErrors}");
+                if (jitter.TotalCount > 0)
+                {
+                    Console.WriteLine($"One-way jitter p50: {Service.GenerateTimePeriod(jitter.ValueAtPercentile(50) / 1000000.0)}");
+                    Console.WriteLine($"One-way jitter p90: {Service.GenerateTimePeriod(jitter.ValueAtPercentile(90) / 1000000.0)}");
+                    Console.WriteLine($"One-way jitter p99: {Service.GenerateTimePeriod(jitter.ValueAtPercentile(99) / 1000000.0)}");
+                    Console.WriteLine($"One-way jitter p99.9: {Service.GenerateTimePeriod(jitter.ValueAtPercentile(99.9) / 1000000.0)}");
+                    Console.WriteLine($"One-way jitter max: {Service.GenerateTimePeriod(jitter.Max / 1000000.0)}");
+                }
+            }
+
+            if (json != null)
+            {
+                result
+                    .Parameter("address", address)
+                    .Parameter("port", port)
+                    .Parameter("threads", threads)
+                    .Parameter("clients", clients)
+                    .Parameter("size", size)
+                    .Parameter("seconds", seconds)
+                    .Parameter("rcvbuf", rcvbuf)
+                    .Metric("errors", TotalErrors)
+                    .Metric("time", (TimestampStop - TimestampStart).TotalMilliseconds * 1000000.0)
+                    .Metric("bytes", TotalBytes)
+                    .Metric("messages", TotalMessages)
+                    .Metric("throughput.bytes", TotalBytes / (TimestampStop - TimestampStart).TotalSeconds)
+                    .Metric("throughput.messages", TotalMessages / (TimestampStop - TimestampStart).TotalSeconds)
+                    .Metric("loss", loss)
+                    .Metric("reordered", reordered)
+                    .Metric("duplicates", duplicates)
+                    .Metric("drops.system", systemErrors)
+                    .Latency("jitter", jitter)
+                    .Write(json);
+            }
         }
     }
 }
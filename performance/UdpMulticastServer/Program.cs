@@ -1,4 +1,5 @@
 ﻿using System;
+using System.Diagnostics;
 using System.Threading;
 using System.Threading.Tasks;
 using CSharpServer;
@@ -88,13 +89,27 @@ namespace UdpMulticastServer
             {
                 // Prepare message to multicast
                 byte[] message = new byte[messageSize];
+                long sequence = 0;
 
                 // Multicasting loop
                 while (multicasting)
                 {
                     var start = DateTime.UtcNow;
                     for (int i = 0; i < messagesRate; ++i)
+                    {
+                        // Stamp the send timestamp and the sequence number to measure loss and jitter
+                        if (messageSize >= 2 * sizeof(long))
+                        {
+                            long timestamp = Stopwatch.GetTimestamp();
+                            ++sequence;
+                            for (int j = 0; j < sizeof(long); ++j)
+                            {
+                                message[j] = (byte)(timestamp >> (j * 8));
+                                message[sizeof(long) + j] = (byte)(sequence >> (j * 8));
+                            }
+                        }
                         server.Multicast(message);
+                    }
                     var end = DateTime.UtcNow;
 
                     // Sleep for remaining time or yield
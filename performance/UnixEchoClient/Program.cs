@@ -0,0 +1,274 @@
+﻿using System;
+using System.IO;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Threading;
+using CSharpServer;
+using CSharpServer.Benchmarks;
+using NDesk.Options;
+
+namespace UnixEchoClient
+{
+    class EchoClient : UnixClient, IOpenLoopClient
+    {
+        public EchoClient(Service service, string path, int messages) : base(service, path)
+        {
+            _messages = messages;
+            _message = (byte[])Program.MessageToSend.Clone();
+            _scheduled = (byte[])Program.MessageToSend.Clone();
+            _stamp = new byte[Math.Min(sizeof(long), _message.Length)];
+        }
+
+        protected override void OnConnected()
+        {
+            if (Program.OpenLoop.Enabled)
+                return;
+
+            for (long i = _messages; i > 0; --i)
+                SendMessage();
+        }
+
+        protected override void OnSent(long sent, long pending)
+        {
+            _sent += sent;
+        }
+
+        protected override void OnReceived(byte[] buffer, long size)
+        {
+            // Reassemble echoed messages to find their send timestamps
+            for (long offset = 0; offset < size;)
+            {
+                long chunk = Math.Min(size - offset, _message.Length - _received);
+                if (_received < _stamp.Length)
+                    Array.Copy(buffer, offset, _stamp, _received, Math.Min(chunk, _stamp.Length - _received));
+                _received += chunk;
+                offset += chunk;
+
+                if (_received == _message.Length)
+                {
+                    Program.OpenLoop.RecordLatency(_stamp, 0);
+                    if (!Program.OpenLoop.Enabled)
+                        SendMessage();
+                    _received = 0;
+                }
+            }
+
+            Program.TimestampStop = DateTime.UtcNow;
+            Program.TotalBytes += size;
+        }
+
+        protected override void OnError(int error, string category, string message)
+        {
+            Console.WriteLine($"Client caught an error with code {error} and category '{category}': {message}");
+            ++Program.TotalErrors;
+        }
+
+        private void SendMessage()
+        {
+            OpenLoop.StampMessage(_message, Stopwatch.GetTimestamp());
+            SendAsync(_message);
+        }
+
+        public void SendScheduled(long timestamp)
+        {
+            OpenLoop.StampMessage(_scheduled, timestamp);
+            SendAsync(_scheduled);
+        }
+
+        private long _sent;
+        private long _received;
+        private long _messages;
+        private byte[] _message;
+        private byte[] _stamp;
+        private byte[] _scheduled;
+    }
+
+    class Program
+    {
+        public static byte[] MessageToSend;
+        public static DateTime TimestampStart = DateTime.UtcNow;
+        public static DateTime TimestampStop = DateTime.UtcNow;
+        public static long TotalErrors;
+        public static long TotalBytes;
+        public static long TotalMessages;
+        public static OpenLoop OpenLoop = new OpenLoop();
+
+        static void Main(string[] args)
+        {
+            bool help = false;
+            string path = Path.Combine(Path.GetTempPath(), "CSharpServer.sock");
+            int threads = Environment.ProcessorCount;
+            int clients = 100;
+            int messages = 1000;
+            int size = 32;
+            int seconds = 10;
+            int warmup = 1;
+            string json = null;
+
+            var options = new OptionSet()
+            {
+                { "h|?|help",   v => help = v != null },
+                { "p|path=", v => path = v },
+                { "t|threads=", v => threads = int.Parse(v) },
+                { "c|clients=", v => clients = int.Parse(v) },
+                { "m|messages=", v => messages = int.Parse(v) },
+                { "s|size=", v => size = int.Parse(v) },
+                { "z|seconds=", v => seconds = int.Parse(v) },
+                { "w|warmup=", v => warmup = int.Parse(v) },
+                { "json=", v => json = v }
+            };
+            OpenLoop.AddOptions(options);
+
+            try
+            {
+                options.Parse(args);
+            }
+            catch (OptionException e)
+            {
+                Console.Write("Command line error: ");
+                Console.WriteLine(e.Message);
+                Console.WriteLine("Try `--help' to get usage information.");
+                return;
+            }
+
+            if (help)
+            {
+                Console.WriteLine("Usage:");
+                options.WriteOptionDescriptions(Console.Out);
+                return;
+            }
+
+            // Capture process CPU time and GC collections from the very beginning
+            var result = (json != null) ? new BenchmarkResult("UnixEcho") : null;
+
+            // Prepare open-loop target rates
+            OpenLoop.Prepare();
+
+            Console.WriteLine($"Server path: {path}");
+            Console.WriteLine($"Working threads: {threads}");
+            Console.WriteLine($"Working clients: {clients}");
+            Console.WriteLine($"Working messages: {messages}");
+            Console.WriteLine($"Message size: {size}");
+            Console.WriteLine($"Seconds to benchmarking: {seconds}");
+            Console.WriteLine($"Seconds to warm-up: {warmup}");
+            if (OpenLoop.Enabled)
+                Console.WriteLine($"Open-loop rates: {string.Join(", ", OpenLoop.Rates)} msg/s");
+            if (size < sizeof(long))
+                Console.WriteLine($"Message size is less than {sizeof(long)} bytes, latency is not measured!");
+
+            Console.WriteLine();
+
+            // Prepare a message to send
+            MessageToSend = new byte[size];
+
+            // Create a new service
+            var service = new Service(threads);
+
+            // Start the service
+            Console.Write("Service starting...");
+            service.Start();
+            Console.WriteLine("Done!");
+
+            // Create echo clients
+            var echoClients = new List<EchoClient>();
+            for (int i = 0; i < clients; ++i)
+            {
+                var client = new EchoClient(service, path, messages);
+                echoClients.Add(client);
+            }
+
+            TimestampStart = DateTime.UtcNow;
+            OpenLoop.WarmupTimestamp = Stopwatch.GetTimestamp() + warmup * Stopwatch.Frequency;
+
+            // Connect clients
+            Console.Write("Clients connecting...");
+            foreach (var client in echoClients)
+                client.ConnectAsync();
+            Console.WriteLine("Done!");
+            foreach (var client in echoClients)
+                while (!client.IsConnected)
+                    Thread.Yield();
+            Console.WriteLine("All clients connected!");
+
+            if (OpenLoop.Enabled)
+            {
+                OpenLoop.Run(echoClients, seconds, warmup);
+                Console.WriteLine();
+            }
+            else
+            {
+                // Wait for benchmarking
+                Console.Write("Benchmarking...");
+                Thread.Sleep(seconds * 1000);
+                Console.WriteLine("Done!");
+            }
+
+            // Disconnect clients
+            Console.Write("Clients disconnecting...");
+            foreach (var client in echoClients)
+                client.DisconnectAsync();
+            Console.WriteLine("Done!");
+            foreach (var client in echoClients)
+                while (client.IsConnected)
+                    Thread.Yield();
+            Console.WriteLine("All clients disconnected!");
+
+            // Stop the service
+            Console.Write("Service stopping...");
+            service.Stop();
+            Console.WriteLine("Done!");
+
+            Console.WriteLine();
+
+            Console.WriteLine($"Errors: {TotalErrors}");
+
+            Console.WriteLine();
+
+            TotalMessages = TotalBytes / size;
+
+            Console.WriteLine($"Total time: {Service.GenerateTimePeriod((TimestampStop - TimestampStart).TotalMilliseconds)}");
+            Console.WriteLine($"Total data: {Service.GenerateDataSize(TotalBytes)}");
+            Console.WriteLine($"Total messages: {TotalMessages}");
+            Console.WriteLine($"Data throughput: {Service.GenerateDataSize((long)(TotalBytes / (TimestampStop - TimestampStart).TotalSeconds))}/s");
+            if (TotalMessages > 0)
+            {
+                Console.WriteLine($"Message throughput: {(long)(TotalMessages / (TimestampStop - TimestampStart).TotalSeconds)} msg/s");
+            }
+
+            Console.WriteLine();
+
+            Console.WriteLine($"Latency samples: {OpenLoop.Latency.TotalCount}");
+            if (OpenLoop.Latency.TotalCount > 0)
+            {
+                Console.WriteLine($"Latency min: {Service.GenerateTimePeriod(OpenLoop.Latency.Min / 1000000.0)}");
+                Console.WriteLine($"Latency mean: {Service.GenerateTimePeriod(OpenLoop.Latency.Mean / 1000000.0)}");
+                Console.WriteLine($"Latency p50: {Service.GenerateTimePeriod(OpenLoop.Latency.ValueAtPercentile(50) / 1000000.0)}");
+                Console.WriteLine($"Latency p90: {Service.GenerateTimePeriod(OpenLoop.Latency.ValueAtPercentile(90) / 1000000.0)}");
+                Console.WriteLine($"Latency p99: {Service.GenerateTimePeriod(OpenLoop.Latency.ValueAtPercentile(99) / 1000000.0)}");
+                Console.WriteLine($"Latency p99.9: {Service.GenerateTimePeriod(OpenLoop.Latency.ValueAtPercentile(99.9) / 1000000.0)}");
+                Console.WriteLine($"Latency max: {Service.GenerateTimePeriod(OpenLoop.Latency.Max / 1000000.0)}");
+            }
+
+            if (json != null)
+            {
+                result
+                    .Parameter("path", path)
+                    .Parameter("threads", threads)
+                    .Parameter("clients", clients)
+                    .Parameter("messages", messages)
+                    .Parameter("size", size)
+                    .Parameter("seconds", seconds)
+                    .Parameter("warmup", warmup)
+                    .Metric("errors", TotalErrors)
+                    .Metric("time", (TimestampStop - TimestampStart).TotalMilliseconds * 1000000.0)
+                    .Metric("bytes", TotalBytes)
+                    .Metric("messages", TotalMessages)
+                    .Metric("throughput.bytes", TotalBytes / (TimestampStop - TimestampStart).TotalSeconds)
+                    .Metric("throughput.messages", TotalMessages / (TimestampStop - TimestampStart).TotalSeconds)
+                    .Latency("latency", OpenLoop.Latency);
+                OpenLoop.Describe(result);
+                result.Write(json);
+            }
+        }
+    }
+}
@@ -0,0 +1,120 @@
+﻿using System;
+using System.IO;
+using CSharpServer;
+using NDesk.Options;
+
+namespace UnixEchoServer
+{
+    class EchoSession : UnixSession
+    {
+        public EchoSession(UnixServer server) : base(server) {}
+
+        protected override void OnReceived(byte[] buffer, long size)
+        {
+            // Resend the message back to the client
+            SendAsync(buffer, 0, size);
+        }
+
+        protected override void OnError(int error, string category, string message)
+        {
+            Console.WriteLine($"Session caught an error with code {error} and category '{category}': {message}");
+        }
+    }
+
+    class EchoServer : UnixServer
+    {
+        public EchoServer(Service service, string path) : base(service, path) {}
+
+        protected override UnixSession CreateSession() { return new EchoSession(this); }
+
+        protected override void OnError(int error, string category, string message)
+        {
+            Console.WriteLine($"Server caught an error with code {error} and category '{category}': {message}");
+        }
+    }
+
+    class Program
+    {
+        static void Main(string[] args)
+        {
+            bool help = false;
+            string path = Path.Combine(Path.GetTempPath(), "CSharpServer.sock");
+            int threads = Environment.ProcessorCount;
+
+            var options = new OptionSet()
+            {
+                { "h|?|help",   v => help = v != null },
+                { "p|path=", v => path = v },
+                { "t|threads=", v => threads = int.Parse(v) }
+            };
+
+            try
+            {
+                options.Parse(args);
+            }
+            catch (OptionException e)
+            {
+                Console.Write("Command line error: ");
+                Console.WriteLine(e.Message);
+                Console.WriteLine("Try `--help' to get usage information.");
+                return;
+            }
+
+            if (help)
+            {
+                Console.WriteLine("Usage:");
+                options.WriteOptionDescriptions(Console.Out);
+                return;
+            }
+
+            Console.WriteLine($"Server path: {path}");
+            Console.WriteLine($"Working threads: {threads}");
+
+            Console.WriteLine();
+
+            // Create a new service
+            var service = new Service(threads);
+
+            // Start the service
+            Console.Write("Service starting...");
+            service.Start();
+            Console.WriteLine("Done!");
+
+            // Create a new echo server
+            var server = new EchoServer(service, path);
+
+            // Start the server
+            Console.Write("Server starting...");
+            server.Start();
+            Console.WriteLine("Done!");
+
+            Console.WriteLine("Press Enter to stop the server or '!' to restart the server...");
+
+            // Perform text input
+            for (;;)
+            {
+                string line = Console.ReadLine();
+                if (line == string.Empty)
+                    break;
+
+                // Restart the server
+                if (line == "!")
+                {
+                    Console.Write("Server restarting...");
+                    server.Restart();
+                    Console.WriteLine("Done!");
+                }
+            }
+
+            // Stop the server
+            Console.Write("Server stopping...");
+            server.Stop();
+            Console.WriteLine("Done!");
+
+            // Stop the service
+            Console.Write("Service stopping...");
+            service.Stop();
+            Console.WriteLine("Done!");
+        }
+    }
+}
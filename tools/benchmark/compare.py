@@ -0,0 +1,243 @@
+#!/usr/bin/env python3
+"""
+Compare CSharpServer benchmark results produced with the --json option.
+
+Results are grouped by benchmark name and parameters. Each group needs
+several runs on both sides; every metric is compared with the Welch's
+t-test and flagged when the change is both statistically significant and
+larger than the threshold.
+
+Usage:
+    compare.py baseline/ candidate/                  compare two directories of *.json results
+    compare.py base1.json base2.json -- cand1.json   compare two lists of result files
+    compare.py baseline/ candidate/ --alpha 0.01     use stricter significance level
+    compare.py baseline/ candidate/ --threshold 5    ignore changes smaller than 5%
+
+Metric polarity comes from the explicit POLARITY table. Significant changes
+of metrics missing from the table are reported as unknown and never counted
+as regressions; add new metrics to the table when adding them to benchmarks.
+
+Exit code is 1 if any significant regression was found.
+"""
+
+import argparse
+import fnmatch
+import glob
+import json
+import math
+import os
+import sys
+
+HIGHER = 1
+LOWER = -1
+INFO = 0
+
+# Metric name patterns with their polarity, the first matching pattern wins
+POLARITY = [
+    # Throughput and totals done in a fixed time
+    ("throughput", HIGHER),
+    ("throughput.*", HIGHER),
+    ("*.throughput", HIGHER),
+    ("openloop.knee", HIGHER),
+    ("bytes", HIGHER),
+    ("messages", HIGHER),
+    ("sessions.connected", HIGHER),
+    # Resumed handshakes save the full ones
+    ("handshakes.resumed", HIGHER),
+    ("server.handshakes.resumed", HIGHER),
+    ("swap.handshakes.resumed", HIGHER),
+    ("handshakes.full", LOWER),
+    ("server.handshakes.full", LOWER),
+    ("swap.handshakes.full", LOWER),
+    ("handshakes.shed", LOWER),
+    # Latency histograms (LatencyHistogram and open-loop percentiles)
+    ("*.count", HIGHER),
+    ("*.min", LOWER),
+    ("*.mean", LOWER),
+    ("*.p50", LOWER),
+    ("*.p90", LOWER),
+    ("*.p99", LOWER),
+    ("*.p99.9", LOWER),
+    ("*.max", LOWER),
+    ("*.latency", LOWER),
+    # Time and resources
+    ("time", LOWER),
+    ("time.*", LOWER),
+    ("*.time", LOWER),
+    ("cpu.*", LOWER),
+    ("gc.*", LOWER),
+    ("*.gc.*", LOWER),
+    ("memory.*", LOWER),
+    ("*.idle.*", LOWER),
+    ("*.active.*", LOWER),
+    ("*.allocated", LOWER),
+    # Failures and datagram losses
+    ("errors", LOWER),
+    ("skipped", LOWER),
+    ("*.timeout", LOWER),
+    ("loss", LOWER),
+    ("*.loss", LOWER),
+    ("reordered", LOWER),
+    ("*.reordered", LOWER),
+    ("duplicates", LOWER),
+    ("*.duplicates", LOWER),
+    ("drops.system", LOWER),
+    ("*.drops.system", LOWER),
+    # Informational metrics without the better direction
+    ("baseline", INFO),
+    ("handshakes.peak", INFO),
+    ("expire.batches", INFO),
+]
+
+
+def load(paths):
+    files = []
+    for path in paths:
+        if os.path.isdir(path):
+            files.extend(sorted(glob.glob(os.path.join(path, "*.json"))))
+        else:
+            files.append(path)
+
+    groups = {}
+    for filename in files:
+        with open(filename, "r", encoding="utf-8-sig") as file:
+            result = json.load(file)
+        key = (result["benchmark"], json.dumps(result.get("parameters", {}), sort_keys=True))
+        group = groups.setdefault(key, {})
+        for name, value in result.get("metrics", {}).items():
+            group.setdefault(name, []).append(float(value))
+    return groups
+
+
+def polarity(metric):
+    """Return the metric polarity or None if the metric is unknown"""
+    for pattern, value in POLARITY:
+        if fnmatch.fnmatchcase(metric, pattern):
+            return value
+    return None
+
+
+def mean_variance(values):
+    mean = sum(values) / len(values)
+    variance = sum((x - mean) ** 2 for x in values) / (len(values) - 1) if len(values) > 1 else 0.0
+    return mean, variance
+
+
+def betacf(a, b, x):
+    # Continued fraction for the incomplete beta function (Numerical Recipes)
+    qab, qap, qam = a + b, a + 1.0, a - 1.0
+    c, d = 1.0, 1.0 - qab * x / qap
+    d = 1.0 / (d if abs(d) > 1e-300 else 1e-300)
+    h = d
+    for m in range(1, 201):
+        m2 = 2 * m
+        aa = m * (b - m) * x / ((qam + m2) * (a + m2))
+        d = 1.0 + aa * d
+        d = 1.0 / (d if abs(d) > 1e-300 else 1e-300)
+        c = 1.0 + aa / c
+        c = c if abs(c) > 1e-300 else 1e-300
+        h *= d * c
+        aa = -(a + m) * (qab + m) * x / ((a + m2) * (qap + m2))
+        d = 1.0 + aa * d
+        d = 1.0 / (d if abs(d) > 1e-300 else 1e-300)
+        c = 1.0 + aa / c
+        c = c if abs(c) > 1e-300 else 1e-300
+        delta = d * c
+        h *= delta
+        if abs(delta - 1.0) < 3e-12:
+            break
+    return h
+
+
+def betai(a, b, x):
+    # Regularized incomplete beta function I_x(a, b)
+    if x <= 0.0:
+        return 0.0
+    if x >= 1.0:
+        return 1.0
+    front = math.exp(math.lgamma(a + b) - math.lgamma(a) - math.lgamma(b) + a * math.log(x) + b * math.log(1.0 - x))
+    if x < (a + 1.0) / (a + b + 2.0):
+        return front * betacf(a, b, x) / a
+    return 1.0 - front * betacf(b, a, 1.0 - x) / b
+
+
+def welch(baseline, candidate):
+    """Return two-sided p-value of the Welch's t-test"""
+    if len(baseline) < 2 or len(candidate) < 2:
+        return None
+    m1, v1 = mean_variance(baseline)
+    m2, v2 = mean_variance(candidate)
+    s1, s2 = v1 / len(baseline), v2 / len(candidate)
+    if s1 + s2 == 0.0:
+        return 1.0 if m1 == m2 else 0.0
+    t = (m2 - m1) / math.sqrt(s1 + s2)
+    df = (s1 + s2) ** 2 / ((s1 ** 2) / (len(baseline) - 1) + (s2 ** 2) / (len(candidate) - 1))
+    return betai(df / 2.0, 0.5, df / (df + t * t))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare CSharpServer benchmark results")
+    parser.add_argument("baseline", nargs="+", help="baseline result files or directories")
+    parser.add_argument("--candidate", nargs="+", help="candidate result files or directories")
+    parser.add_argument("--alpha", type=float, default=0.05, help="significance level (default: 0.05)")
+    parser.add_argument("--threshold", type=float, default=2.0, help="minimal relative change in percent (default: 2)")
+    parser.add_argument("--all", action="store_true", help="print all metrics, not only changed ones")
+    argv = sys.argv[1:]
+    if "--" in argv:
+        split = argv.index("--")
+        argv = argv[:split] + ["--candidate"] + argv[split + 1:]
+    args = parser.parse_args(argv)
+
+    baseline_paths, candidate_paths = args.baseline, args.candidate
+    if candidate_paths is None:
+        if len(baseline_paths) != 2:
+            parser.error("expected two directories or two lists of files separated by '--'")
+        baseline_paths, candidate_paths = [baseline_paths[0]], [baseline_paths[1]]
+
+    baseline = load(baseline_paths)
+    candidate = load(candidate_paths)
+
+    regressions = 0
+    unknown = set()
+    for key in sorted(set(baseline) & set(candidate)):
+        benchmark, parameters = key
+        print("%s %s" % (benchmark, parameters))
+        for metric in sorted(set(baseline[key]) & set(candidate[key])):
+            base, cand = baseline[key][metric], candidate[key][metric]
+            m1, _ = mean_variance(base)
+            m2, _ = mean_variance(cand)
+            change = ((m2 - m1) / abs(m1) * 100.0) if m1 != 0.0 else (0.0 if m2 == 0.0 else math.inf)
+            p = welch(base, cand)
+
+            significant = (p is not None) and (p < args.alpha) and (abs(change) >= args.threshold)
+            direction = polarity(metric)
+            if direction is None:
+                unknown.add(metric)
+            if not significant:
+                status = ""
+            elif direction is None:
+                status = "changed (unknown metric)"
+            elif direction == INFO:
+                status = "changed"
+            elif (change > 0) == (direction == HIGHER):
+                status = "improvement"
+            else:
+                status = "REGRESSION"
+                regressions += 1
+
+            if status or args.all:
+                print("  %-28s %16.3f -> %16.3f  %+8.2f%%  p=%s  %s" % (
+                    metric, m1, m2, change, "n/a" if p is None else "%.4f" % p, status))
+
+    for key in sorted(set(baseline) ^ set(candidate)):
+        print("%s %s: present only in the %s" % (key[0], key[1], "baseline" if key in baseline else "candidate"))
+
+    print()
+    if unknown:
+        print("Unknown metrics (not judged): %s" % ", ".join(sorted(unknown)))
+    print("Regressions: %d" % regressions)
+    return 1 if regressions > 0 else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,228 @@
+#!/usr/bin/env python3
+"""
+Run CSharpServer server/client benchmark pairs on disjoint CPU core sets.
+
+The server and the client processes are pinned to separate cores, so they
+do not fight for CPU. The orchestrator sweeps server threads, client counts
+and message sizes, stores each client result (--json) and builds a matrix
+of the main metrics averaged over repeats. Failed runs are counted in the
+matrix and do not stop the sweep. Result files can be compared between
+builds with compare.py.
+
+Usage:
+    orchestrate.py --bin path/to/release                       TCP echo with default sweep
+    orchestrate.py --bin . --pair ssl --threads 1,2,4          SSL echo, sweep server threads
+    orchestrate.py --bin . --server-cores 0-3 --client-cores 4-7 --clients 1,10,100 --sizes 32,4096
+    orchestrate.py --bin . --out results/2024-01 --repeat 5 --seconds 10
+    orchestrate.py --bin . --pair ssl --suites TLS_AES_128_GCM_SHA256,TLS_CHACHA20_POLY1305_SHA256,ECDHE-RSA-AES128-GCM-SHA256 --groups X25519
+
+SSL suites are OpenSSL cipher names: TLS 1.3 suites start with "TLS_" and
+run with the generic TLS method, others are TLS 1.2 cipher lists.
+"""
+
+import argparse
+import csv
+import ctypes
+import itertools
+import json
+import os
+import socket
+import subprocess
+import sys
+import time
+
+PAIRS = {
+    "tcp": ("TcpEchoServer", "TcpEchoClient", 1111),
+    "ssl": ("SslEchoServer", "SslEchoClient", 2222),
+    "udp": ("UdpEchoServer", "UdpEchoClient", 3333),
+}
+
+METRICS = ["throughput.messages", "throughput.bytes", "time.handshake.burst", "latency.p50", "latency.p99", "latency.p99.9", "errors", "cpu.time"]
+
+
+def parse_cores(text):
+    cores = []
+    for part in text.split(","):
+        if "-" in part:
+            first, last = part.split("-")
+            cores.extend(range(int(first), int(last) + 1))
+        elif part:
+            cores.append(int(part))
+    return sorted(set(cores))
+
+
+def parse_list(text):
+    return [int(x) for x in text.split(",") if x]
+
+
+def suite_args(suite, groups):
+    """SSL suite options shared by the server and the client"""
+    args = []
+    if suite:
+        args += ["--method=TLS", "--suites=" + suite] if suite.startswith("TLS_") else ["--ciphers=" + suite]
+    if groups:
+        args.append("--groups=" + groups)
+    return args
+
+
+def executable(bin_dir, name):
+    path = os.path.join(bin_dir, name + ".exe")
+    return path if os.path.exists(path) else os.path.join(bin_dir, name)
+
+
+def launch(command, cores, cwd, **kwargs):
+    """Start the process pinned to the given cores"""
+    mask = sum(1 << core for core in cores)
+    if sys.platform == "win32":
+        process = subprocess.Popen(command, cwd=cwd, **kwargs)
+        # Process affinity applies to all threads, including ones created later
+        if not ctypes.windll.kernel32.SetProcessAffinityMask(int(process._handle), ctypes.c_size_t(mask)):
+            process.kill()
+            raise OSError("SetProcessAffinityMask failed for cores %s" % cores)
+        return process
+    # Affinity set before exec is inherited by all threads of the new process
+    return subprocess.Popen(command, cwd=cwd, preexec_fn=lambda: os.sched_setaffinity(0, cores), **kwargs)
+
+
+def wait_port(pair, port, timeout):
+    if pair == "udp":
+        time.sleep(1.0)
+        return
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        try:
+            with socket.create_connection(("127.0.0.1", port), timeout=0.5):
+                return
+        except OSError:
+            time.sleep(0.1)
+    raise TimeoutError("Server did not open port %d" % port)
+
+
+def stop(process):
+    try:
+        process.communicate(input=b"\n", timeout=10)
+    except subprocess.TimeoutExpired:
+        process.kill()
+        process.wait()
+
+
+def run(args, server_cores, client_cores, threads, clients, size, suite, repeat):
+    server_name, client_name, port = PAIRS[args.pair]
+    name = "%s-t%d-c%d-s%d%s-r%d" % (args.pair, threads, clients, size, ("-" + suite.replace(":", "+")) if suite else "", repeat)
+    result = os.path.abspath(os.path.join(args.out, name + ".json"))
+    ssl = suite_args(suite, args.groups) if args.pair == "ssl" else []
+    # Stale result of the previous sweep must not be taken for this run
+    if os.path.exists(result):
+        os.remove(result)
+
+    server = launch([executable(args.bin, server_name), "-p", str(port), "-t", str(threads)] + ssl,
+                    server_cores, args.bin, stdin=subprocess.PIPE, stdout=subprocess.DEVNULL)
+    try:
+        wait_port(args.pair, port, 30)
+        client = launch([executable(args.bin, client_name), "-p", str(port),
+                         "-t", str(args.client_threads or len(client_cores)), "-c", str(clients), "-s", str(size),
+                         "-z", str(args.seconds), "-w", str(args.warmup), "--json=" + result] + ssl + args.client_args,
+                        client_cores, args.bin, stdout=subprocess.DEVNULL)
+        client.wait()
+    except TimeoutError as e:
+        print("Failed: %s" % e, file=sys.stderr)
+        return None
+    finally:
+        stop(server)
+
+    # Failed run is recorded by the caller and the sweep goes on
+    if client.returncode != 0:
+        print("Failed: %s exited with code %d" % (client_name, client.returncode), file=sys.stderr)
+        return None
+    try:
+        with open(result, "r", encoding="utf-8-sig") as file:
+            data = json.load(file)
+    except (OSError, ValueError) as e:
+        print("Failed: no valid result %s (%s)" % (result, e), file=sys.stderr)
+        return None
+    # Record the orchestration parameters so compare.py groups runs by them
+    data["parameters"]["server_threads"] = threads
+    data["parameters"]["server_cores"] = ",".join(map(str, server_cores))
+    data["parameters"]["client_cores"] = ",".join(map(str, client_cores))
+    with open(result, "w", encoding="utf-8") as file:
+        json.dump(data, file, indent=2)
+    return data["metrics"]
+
+
+def main():
+    cpus = os.cpu_count() or 2
+    # Single CPU has no disjoint halves, both processes default to core 0
+    half = max(cpus // 2, 1)
+    parser = argparse.ArgumentParser(description="Run CSharpServer benchmark pairs on disjoint core sets")
+    parser.add_argument("--bin", default=".", help="directory with benchmark executables and certificates")
+    parser.add_argument("--pair", choices=sorted(PAIRS), default="tcp", help="benchmark pair (default: tcp)")
+    parser.add_argument("--server-cores", default="0-%d" % (half - 1), help="server cores (default: first half)")
+    parser.add_argument("--client-cores", default="%d-%d" % (min(half, cpus - 1), cpus - 1), help="client cores (default: second half)")
+    parser.add_argument("--threads", help="server threads to sweep (default: powers of two up to server cores)")
+    parser.add_argument("--client-threads", type=int, help="client threads (default: number of client cores)")
+    parser.add_argument("--clients", default="1,10,100", help="client counts to sweep (default: 1,10,100)")
+    parser.add_argument("--sizes", default="32", help="message sizes to sweep (default: 32)")
+    parser.add_argument("--suites", help="comma separated SSL suites to sweep (ssl pair only)")
+    parser.add_argument("--groups", help="SSL key exchange groups for all runs (ssl pair only, e.g. X25519)")
+    parser.add_argument("--seconds", type=int, default=10, help="seconds per run (default: 10)")
+    parser.add_argument("--warmup", type=int, default=1, help="warm-up seconds per run (default: 1)")
+    parser.add_argument("--repeat", type=int, default=3, help="runs per point (default: 3)")
+    parser.add_argument("--out", default="results", help="output directory (default: results)")
+    parser.add_argument("client_args", nargs="*", help="extra client arguments after '--'")
+    args = parser.parse_args()
+
+    args.bin = os.path.abspath(args.bin)
+    server_cores = parse_cores(args.server_cores)
+    client_cores = parse_cores(args.client_cores)
+    if set(server_cores) & set(client_cores):
+        if cpus > 1 or args.server_cores != parser.get_default("server_cores") or args.client_cores != parser.get_default("client_cores"):
+            parser.error("server and client core sets must be disjoint")
+        print("Warning: single CPU, server and client share core 0", file=sys.stderr)
+    threads = parse_list(args.threads) if args.threads else [1 << i for i in range(len(server_cores).bit_length()) if (1 << i) <= len(server_cores)]
+    os.makedirs(args.out, exist_ok=True)
+
+    print("Server cores: %s" % server_cores)
+    print("Client cores: %s" % client_cores)
+
+    suites = [x for x in args.suites.split(",") if x] if (args.suites and args.pair == "ssl") else [""]
+
+    rows = []
+    failed = 0
+    for t, c, s, suite in itertools.product(threads, parse_list(args.clients), parse_list(args.sizes), suites):
+        runs = []
+        failures = 0
+        for r in range(args.repeat):
+            print("Running %s threads=%d clients=%d size=%d%s (%d/%d)..." % (args.pair, t, c, s, (" suite=" + suite) if suite else "", r + 1, args.repeat), flush=True)
+            metrics = run(args, server_cores, client_cores, t, c, s, suite, r)
+            if metrics is None:
+                failures += 1
+            else:
+                runs.append(metrics)
+        failed += failures
+        row = {"threads": t, "clients": c, "size": s, "suite": suite, "failures": failures}
+        for metric in METRICS:
+            values = [m[metric] for m in runs if metric in m]
+            row[metric] = sum(values) / len(values) if values else ""
+        rows.append(row)
+
+    matrix = os.path.join(args.out, "matrix-%s.csv" % args.pair)
+    with open(matrix, "w", newline="") as file:
+        writer = csv.DictWriter(file, fieldnames=["threads", "clients", "size", "suite", "failures"] + METRICS)
+        writer.writeheader()
+        writer.writerows(rows)
+
+    print()
+    print("%8s %8s %8s %16s %14s %14s %14s %8s  %s" % ("threads", "clients", "size", "msg/s", "hs burst (ms)", "p50 (ns)", "p99 (ns)", "failed", "suite"))
+    for row in rows:
+        print("%8d %8d %8d %16.0f %14.1f %14.0f %14.0f %8d  %s" % (row["threads"], row["clients"], row["size"], row["throughput.messages"] or 0,
+                                                                 (row["time.handshake.burst"] or 0) / 1000000.0, row["latency.p50"] or 0, row["latency.p99"] or 0,
+                                                                 row["failures"], row["suite"]))
+    print()
+    print("Matrix: %s" % matrix)
+    if failed:
+        print("Failed runs: %d" % failed)
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
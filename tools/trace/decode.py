@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+"""
+Decode CSharpServer binary trace dump produced by Service.DumpTrace().
+
+Usage:
+    decode.py trace.bin                  print all events ordered by time
+    decode.py trace.bin --id 1a2b3c4d    print events of the given session/client trace Id
+    decode.py trace.bin --event Error    print events of the given kind
+    decode.py trace.bin --summary        print event counts per kind and per thread
+"""
+
+import argparse
+import datetime
+import struct
+import sys
+
+HEADER = struct.Struct("<8sIIQQQQII")
+RING = struct.Struct("<IIQ")
+RECORD = struct.Struct("<QQQIB3x")
+
+EVENTS = {
+    1: "Accept",
+    2: "Connect",
+    3: "Handshake",
+    4: "Receive",
+    5: "Send",
+    6: "Flush",
+    7: "Disconnect",
+    8: "Error",
+}
+
+
+def read_dump(filename):
+    with open(filename, "rb") as file:
+        data = file.read()
+
+    magic, version, record_size, origin_tsc, origin_utc, dump_tsc, dump_utc, rings, _ = HEADER.unpack_from(data, 0)
+    if magic != b"CSTRACE\0":
+        raise ValueError("Invalid trace dump magic")
+    if version != 1 or record_size != RECORD.size:
+        raise ValueError("Unsupported trace dump version {} (record size {})".format(version, record_size))
+
+    # Convert TSC into UTC time with two clock samples taken by the service
+    ns_per_tick = (dump_utc - origin_utc) / (dump_tsc - origin_tsc) if dump_tsc > origin_tsc else 1.0
+
+    events = []
+    offset = HEADER.size
+    for _ in range(rings):
+        ring, _, count = RING.unpack_from(data, offset)
+        offset += RING.size
+        for _ in range(count):
+            tsc, id, value, thread, event = RECORD.unpack_from(data, offset)
+            offset += RECORD.size
+            utc = origin_utc + int((tsc - origin_tsc) * ns_per_tick)
+            events.append((utc, ring, thread, id, EVENTS.get(event, str(event)), value))
+
+    events.sort(key=lambda e: e[0])
+    return events
+
+
+def format_time(utc):
+    seconds, nanoseconds = divmod(int(utc), 1000000000)
+    time = datetime.datetime.fromtimestamp(seconds, datetime.timezone.utc)
+    return "{}.{:09d}".format(time.strftime("%Y-%m-%d %H:%M:%S"), nanoseconds)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="CSharpServer trace dump decoder")
+    parser.add_argument("filename", help="Trace dump filename")
+    parser.add_argument("--id", help="Filter by session/client trace Id (hex)")
+    parser.add_argument("--event", help="Filter by event kind")
+    parser.add_argument("--summary", action="store_true", help="Print event counts only")
+    args = parser.parse_args()
+
+    try:
+        events = read_dump(args.filename)
+    except (OSError, ValueError, struct.error) as ex:
+        print("Cannot decode trace dump: {}".format(ex), file=sys.stderr)
+        return 1
+
+    if args.id is not None:
+        id = int(args.id, 16)
+        events = [e for e in events if e[3] == id]
+    if args.event is not None:
+        events = [e for e in events if e[4].lower() == args.event.lower()]
+
+    if args.summary:
+        kinds = {}
+        threads = {}
+        for e in events:
+            kinds[e[4]] = kinds.get(e[4], 0) + 1
+            threads[e[2]] = threads.get(e[2], 0) + 1
+        print("Events: {}".format(len(events)))
+        for kind, count in sorted(kinds.items()):
+            print("  {:<12} {}".format(kind, count))
+        print("Threads: {}".format(len(threads)))
+        for thread, count in sorted(threads.items()):
+            print("  {:08x}     {}".format(thread, count))
+        return 0
+
+    previous = None
+    for utc, ring, thread, id, event, value in events:
+        delta = (utc - previous) if previous is not None else 0
+        previous = utc
+        print("{} +{:>10.0f}ns thread={:08x} id={:016x} {:<10} {}".format(format_time(utc), delta, thread, id, event, value))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())